@@ -46,6 +46,10 @@ const char* LWT_PAYLOAD = "pub_speed_test died unexpectedly.";
 // Queue for passing tokens to the wait thread
 mqtt::thread_queue<mqtt::delivery_token_ptr> que;
 
+// The number of times the wait thread spins on an empty queue before
+// sleeping. This cuts the latency of handing off the tokens.
+const unsigned QUE_SPIN_BUDGET = 4000, QUE_YIELD_BUDGET = 8;
+
 // Get the current time on the steady clock
 steady_clock::time_point now() { return steady_clock::now(); }
 
@@ -109,6 +113,7 @@ int main(int argc, char* argv[])
 
         cout << "Connected in " << msec(end - start) << "ms" << endl;
 
+        que.spin_budget(QUE_SPIN_BUDGET, QUE_YIELD_BUDGET);
         auto fut = std::async(launch::async, token_wait_func);
 
         // Publish the messages
@@ -0,0 +1,170 @@
+// topic_matcher_bench.cpp
+//
+// Paho C++ sample application to compare the memory use and the match
+// speed of the topic_matcher, flat_topic_matcher, and
+// compiled_topic_matcher collections.
+//
+// This doesn't need a broker. It fills each collection with the same set
+// of filters, like a broker or gateway might have for a fleet of devices,
+// then matches a set of topics against them.
+//
+// USAGE:
+//     topic_matcher_bench [n_sites] [n_devices]
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mqtt/compiled_topic_matcher.h"
+#include "mqtt/flat_topic_matcher.h"
+#include "mqtt/topic_matcher.h"
+
+using namespace std;
+using namespace std::chrono;
+
+const int DFLT_N_SITES = 200, DFLT_N_DEVICES = 100;
+
+const char* SENSORS[] = {"temp", "humidity", "pressure", "status"};
+
+// The number of passes over the topics when timing the matches
+const int N_PASS = 10;
+
+// --------------------------------------------------------------------------
+// Gets the number of bytes in use from the heap, to measure the size of
+// the collections. This is only available with glibc.
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    #include <malloc.h>
+    #define HAVE_HEAP_BYTES
+size_t heap_bytes() { return mallinfo2().uordblks; }
+#else
+size_t heap_bytes() { return 0; }
+#endif
+
+// --------------------------------------------------------------------------
+// Builds a collection from the filters.
+
+template <class Matcher>
+Matcher build(const vector<string>& filters)
+{
+    Matcher tm;
+    for (size_t i = 0; i < filters.size(); ++i) tm.insert({filters[i], int(i)});
+    return tm;
+}
+
+// The compiled matcher is built in one shot from the full list.
+template <>
+mqtt::compiled_topic_matcher<int> build(const vector<string>& filters)
+{
+    vector<pair<string, int>> vals;
+    for (size_t i = 0; i < filters.size(); ++i) vals.push_back({filters[i], int(i)});
+    return mqtt::compiled_topic_matcher<int>{std::move(vals)};
+}
+
+// Counts the matches for a topic with a match iterator.
+template <class Matcher>
+size_t count_matches(Matcher& tm, const string& topic)
+{
+    size_t n = 0;
+    for (auto it = tm.matches(topic); it != tm.matches_cend(); ++it) ++n;
+    return n;
+}
+
+// The compiled matcher gets all the matches at once.
+size_t count_matches(mqtt::compiled_topic_matcher<int>& tm, const string& topic)
+{
+    static vector<const pair<string, int>*> v;
+    v.clear();
+    return tm.matches(topic, v);
+}
+
+// --------------------------------------------------------------------------
+// Builds a collection from the filters, reporting the memory it used, then
+// matches all the topics against it, reporting the time per match.
+
+template <class Matcher>
+void run(const char* name, const vector<string>& filters, const vector<string>& topics)
+{
+    size_t startBytes = heap_bytes();
+    auto tm = build<Matcher>(filters);
+    size_t nBytes = heap_bytes() - startBytes;
+
+    size_t nMatch = 0;
+    auto start = steady_clock::now();
+
+    for (int pass = 0; pass < N_PASS; ++pass) {
+        for (const auto& topic : topics) nMatch += count_matches(tm, topic);
+    }
+
+    auto dur = steady_clock::now() - start;
+    auto nsPerMatch =
+        double(duration_cast<nanoseconds>(dur).count()) / (N_PASS * topics.size());
+
+    cout << name << ":\n";
+#if defined(HAVE_HEAP_BYTES)
+    cout << "  Memory:  " << nBytes << " bytes (" << (nBytes / filters.size())
+         << " per filter)\n";
+#else
+    (void)nBytes;
+#endif
+    cout << "  Matches: " << (nMatch / N_PASS) << " per pass\n"
+         << "  Latency: " << nsPerMatch << " ns per topic\n"
+         << endl;
+}
+
+// --------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    int nSites = (argc > 1) ? atoi(argv[1]) : DFLT_N_SITES,
+        nDevices = (argc > 2) ? atoi(argv[2]) : DFLT_N_DEVICES;
+
+    vector<string> filters, topics;
+
+    for (int i = 0; i < nSites; ++i) {
+        auto site = "site/" + to_string(i);
+        filters.push_back(site + "/#");
+        filters.push_back(site + "/+/status");
+
+        for (int j = 0; j < nDevices; ++j) {
+            auto dev = site + "/dev" + to_string(j);
+            filters.push_back(dev + "/+");
+
+            for (const auto& sensor : SENSORS) {
+                filters.push_back(dev + "/" + sensor);
+                topics.push_back(dev + "/" + sensor);
+            }
+        }
+        // A topic that only matches the wildcards
+        topics.push_back(site + "/unknown/status");
+    }
+
+    cout << "Filters: " << filters.size() << "\n"
+         << "Topics:  " << topics.size() << "\n"
+         << endl;
+
+    run<mqtt::topic_matcher<int>>("topic_matcher", filters, topics);
+    run<mqtt::flat_topic_matcher<int>>("flat_topic_matcher", filters, topics);
+    run<mqtt::compiled_topic_matcher<int>>("compiled_topic_matcher", filters, topics);
+
+    return 0;
+}
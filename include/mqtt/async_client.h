@@ -34,6 +34,7 @@
 #ifndef __mqtt_async_client_h
 #define __mqtt_async_client_h
 
+#include <atomic>
 #include <functional>
 #include <list>
 #include <memory>
@@ -43,6 +44,8 @@
 
 #include "MQTTAsync.h"
 #include "mqtt/callback.h"
+#include "mqtt/conflating_queue.h"
+#include "mqtt/consumer_queue.h"
 #include "mqtt/create_options.h"
 #include "mqtt/delivery_token.h"
 #include "mqtt/event.h"
@@ -51,10 +54,15 @@
 #include "mqtt/iasync_client.h"
 #include "mqtt/iclient_persistence.h"
 #include "mqtt/message.h"
+#include "mqtt/message_router.h"
 #include "mqtt/properties.h"
+#include "mqtt/ring_queue.h"
+#include "mqtt/sharded_dispatcher.h"
 #include "mqtt/string_collection.h"
 #include "mqtt/thread_queue.h"
 #include "mqtt/token.h"
+#include "mqtt/topic_alias_table.h"
+#include "mqtt/topic_intern_table.h"
 #include "mqtt/types.h"
 
 namespace mqtt {
@@ -123,7 +131,7 @@ public:
     /** Smart/shared pointer for an object of this class */
     using ptr_t = std::shared_ptr<async_client>;
     /** Type for a thread-safe queue to consume events synchronously */
-    using consumer_queue_type = std::unique_ptr<thread_queue<event>>;
+    using consumer_queue_type = consumer_queue_ptr;
 
     /** Handler type for registering an individual message callback */
     using message_handler = std::function<void(const_message_ptr)>;
@@ -172,6 +180,26 @@ private:
     std::list<delivery_token_ptr> pendingDeliveryTokens_;
     /** A queue of messages for consumer API */
     consumer_queue_type que_;
+    /** The workers for sharded message dispatch (if any) */
+    sharded_dispatcher_ptr dispatcher_;
+    /** The per-filter message routes */
+    message_router router_;
+    /** Lock to keep the topic aliases in the order the messages are sent */
+    mutable std::mutex aliasLock_;
+    /** The most topic aliases to use, or zero if they're disabled */
+    uint16_t aliasLimit_{0};
+    /** The most topic aliases the server allows on the current connection */
+    uint16_t aliasServerMax_{0};
+    /** Whether the next connected callback is for the connection of connTok_ */
+    std::atomic<bool> connRspPending_{false};
+    /** The topic aliases for the current connection */
+    topic_alias_table aliases_;
+    /** The shared topics of incoming messages, and the server's aliases */
+    topic_intern_table inTopics_;
+    /** Counts the connections, so the incoming aliases can be cleared */
+    std::atomic<unsigned> connGen_{0};
+    /** The connection that the incoming aliases are for */
+    unsigned inTopicsGen_{0};
 
     /** Callbacks from the C library */
     static void on_connected(void* context, char* cause);
@@ -185,6 +213,11 @@ private:
     static void on_delivery_complete(void* context, MQTTAsync_token tok);
     static int on_update_connection(void* context, MQTTAsync_connectData* cdata);
 
+    /** Sets the topic aliases for a new connection, or clears them */
+    void reset_topic_aliases(uint16_t serverMax);
+    /** Sends a message to the C lib, with a topic alias if enabled */
+    int send_message(const message& msg, MQTTAsync_responseOptions& opts);
+
     /** Manage internal list of active tokens */
     friend class token;
     virtual void add_token(token_ptr tok);
@@ -198,6 +231,21 @@ private:
     async_client(const async_client&) = delete;
     async_client& operator=(const async_client&) = delete;
 
+    /**
+     * Converts a batch of events to messages for the batch message
+     * consumer. Messages are appended to the vector, 'connected' events are
+     * skipped, and any type of disconnect is passed as an empty pointer.
+     * @return The number of items appended to the message vector.
+     */
+    static size_t events_to_messages(
+        std::vector<event>& evts, std::vector<const_message_ptr>& msgs
+    );
+    /**
+     * Gets the calling thread's scratch buffer for reading events in the
+     * batch message consumer, so that it doesn't allocate on each batch.
+     * @return An empty vector, reused on each call from the same thread.
+     */
+    static std::vector<event>& event_buffer();
     /** Checks a function return code and throws on error. */
     static void check_ret(int rc) {
         if (rc != MQTTASYNC_SUCCESS)
@@ -331,6 +379,105 @@ public:
      * @param cb The callback functor to register with the library.
      */
     void set_message_callback(message_handler cb) /*override*/;
+    /**
+     * Adds a route to send incoming messages that match a topic filter
+     * directly to a handler.
+     *
+     * This is independent of the message callback and the consumer queue.
+     * Every incoming message is matched against the filters of all the
+     * routes, and is sent to the handler of each one that it matches. The
+     * routes can be added and removed at any time, from any thread.
+     * Adding a route for a filter that already has one replaces it.
+     * @par
+     * A direct route runs the handler from the library's callback thread,
+     * so it should be quick and not block. A worker route runs it on a pool
+     * of worker threads, which keeps the messages for each topic in order.
+     * The pool is started with the first worker route, unless it was
+     * already started with @ref start_route_workers().
+     * @par
+     * Like the message callback, the routes don't receive messages after
+     * @ref stop_consuming() until consuming is restarted.
+     *
+     * @param filter The topic filter.
+     * @param handler The handler for messages that match the filter.
+     * @param mode Whether the handler runs directly, or on a worker.
+     * @throw std::invalid_argument if the handler is empty.
+     */
+    void add_route(
+        const string& filter, message_handler handler, route_mode mode = route_mode::direct
+    );
+    /**
+     * Removes the route for a topic filter.
+     * @param filter The topic filter.
+     * @return @em true if the route was removed, @em false if there was no
+     *  	   route for the filter.
+     */
+    bool remove_route(const string& filter) { return router_.remove_route(filter); }
+    /**
+     * Starts the pool of worker threads for the worker routes.
+     * This is only needed to choose the number or options of the workers.
+     * Otherwise the pool is started, with a thread for each CPU, when the
+     * first worker route is added.
+     * @param nWorkers The number of worker threads.
+     * @param opts Options for the workers, such as the CPU affinity and
+     *  		   names of the threads. The messages are always sharded
+     *  		   by topic, so any key function is ignored.
+     * @return @em true if the workers were started, @em false if they were
+     *  	   already running.
+     */
+    bool start_route_workers(
+        size_t nWorkers, const dispatch_options& opts = dispatch_options{}
+    ) {
+        return router_.start_workers(nWorkers, opts);
+    }
+    /**
+     * Enables automatic MQTT v5 topic aliases for the QoS 0 messages that
+     * are published.
+     *
+     * When the client connects, it gets the most aliases that the server
+     * will accept from the @em TOPIC_ALIAS_MAXIMUM property of the connect
+     * response. Each time a QoS 0 message is published, its topic is given an
+     * alias, if there's room. The first message on a topic is sent with the
+     * full name and the alias, and after that, messages on the topic are
+     * sent with an empty topic and just the alias. When all the aliases are
+     * in use, one that wasn't used recently is reassigned.
+     * @par
+     * The aliases are cleared when the connection is lost, and start again
+     * from scratch each time the client connects. No aliases are used for
+     * MQTT v3 connections, for servers that don't allow them, or for
+     * messages that already have a @em TOPIC_ALIAS property. The
+     * application shouldn't assign its own aliases while this is enabled.
+     * @par
+     * The client doesn't get the connect response for an automatic
+     * reconnect, so it can't tell how many aliases the server allows. No
+     * aliases are used on those connections, until the application calls
+     * @ref connect() or @ref reconnect().
+     * @par
+     * QoS 1 and 2 messages are always sent with their full topic and no
+     * alias. The library resends them after a reconnect to a server that
+     * kept the session, and an alias from the old connection would then be
+     * a protocol error. QoS 0 messages published while disconnected never
+     * get an alias. But one that was given an alias and was still waiting
+     * to go out when the connection was lost is already in the hands of
+     * the C library, which can't take the alias back, and may send it after
+     * the reconnect. So aliases shouldn't be combined with sending while
+     * disconnected.
+     *
+     * @param maxAliases The most aliases to use. The actual number is the
+     *  				 smaller of this and the maximum allowed by the
+     *  				 server.
+     */
+    void enable_topic_aliases(uint16_t maxAliases = topic_alias_table::MAX_ALIASES);
+    /**
+     * Disables automatic topic aliases.
+     * Messages are sent with their full topic names from then on.
+     */
+    void disable_topic_aliases() { enable_topic_aliases(0); }
+    /**
+     * Determines if automatic topic aliases are enabled.
+     * @return @em true if automatic topic aliases are enabled.
+     */
+    bool topic_aliases_enabled() const;
     /**
      * Sets a callback to allow the application to update the connection
      * data on automatic reconnects.
@@ -662,6 +809,38 @@ public:
         const subscribe_options& opts = subscribe_options(),
         const properties& props = properties()
     ) override;
+    /**
+     * Subscribe to a topic, which may include wildcards, with a route to
+     * send the messages that match it directly to a handler.
+     *
+     * This adds a route for the filter, as with @ref add_route(), before
+     * subscribing. On an MQTT v5 connection the route is assigned a
+     * subscription identifier, which is sent with the subscribe request.
+     * The server then tags the messages with the identifiers of the
+     * subscriptions that they match, so as long as every route has an
+     * identifier, incoming messages are sent to their handlers by a table
+     * lookup, without matching their topics against the filters. With
+     * MQTT v3, the messages are routed by matching their topics.
+     *
+     * @param topicFilter the topic to subscribe to, which can include
+     *  				  wildcards.
+     * @param qos The quality of service for the subscription
+     * @param handler The handler for messages that match the filter.
+     * @param mode Whether the handler runs directly, or on a worker.
+     * @param opts The MQTT v5 subscribe options for the topic
+     * @param props The MQTT v5 properties. These must not contain a
+     *  			subscription identifier.
+     * @return token used to track and wait for the subscribe to complete.
+     *  	   The token will be passed to callback methods if set.
+     * @throw std::invalid_argument if the handler is empty, or the
+     *  	  properties already contain a subscription identifier.
+     */
+    token_ptr subscribe(
+        const string& topicFilter, int qos, message_handler handler,
+        route_mode mode = route_mode::direct,
+        const subscribe_options& opts = subscribe_options(),
+        const properties& props = properties()
+    );
     /**
      * Subscribe to multiple topics, each of which may include wildcards.
      * @param topicFilters The collection of topic filters to subscribe to,
@@ -779,6 +958,94 @@ public:
      * push events into the queue in the order received.
      */
     void start_consuming() override;
+    /**
+     * Start consuming messages using the specified queue.
+     *
+     * This is the same as @ref start_consuming(), but lets the application
+     * choose the type of queue that holds the events. For example, to use
+     * a lock-free, bounded queue for high message rates:
+     *
+     * @code
+     * cli.start_consuming(consumer_queue<ring_queue<event>>::create(4096));
+     * @endcode
+     *
+     * Or to conflate messages by topic, so that the consumer only sees the
+     * latest message for each topic:
+     *
+     * @code
+     * cli.start_consuming(consumer_queue<conflating_event_queue>::create());
+     * @endcode
+     *
+     * Or to have connect and disconnect events bypass any backlog of
+     * messages waiting in the queue:
+     *
+     * @code
+     * cli.start_consuming(priority_consumer_queue<>::create());
+     * @endcode
+     *
+     * @param que The queue to use for the consumer. If this is null, the
+     *  		  default, unbounded, queue is created.
+     */
+    void start_consuming(consumer_queue_type que);
+    /**
+     * Start consuming messages with a bounded queue.
+     * This is the same as @ref start_consuming(), but limits the number of
+     * events that can be held in the queue, and sets what happens when a
+     * new event arrives while the queue is full.
+     * @par
+     * Note that the events are put into the queue from the callback thread
+     * of the underlying C library. With the default @em block policy a
+     * slow consumer will stall that thread, which also delays keep-alives
+     * and acknowledgments for the connection. The other policies keep the
+     * thread running by discarding events, and the number discarded can be
+     * read with @ref consumer_queue_dropped().
+     * @param capacity The maximum number of events in the queue.
+     * @param policy What to do when an event arrives and the queue is full.
+     */
+    void start_consuming(size_t capacity, overflow_policy policy = overflow_policy::block);
+    /**
+     * Start consuming messages with a bounded queue that blocks for a
+     * limited time when full.
+     * When the queue is full, an incoming event will wait up to the
+     * deadline for space to become available before being discarded. This
+     * is normally used with the @em block_with_deadline policy.
+     * @param capacity The maximum number of events in the queue.
+     * @param policy What to do when an event arrives and the queue is full.
+     * @param deadline The maximum time to block the callback thread before
+     *  			   discarding an event.
+     */
+    template <typename Rep, class Period>
+    void start_consuming(
+        size_t capacity, overflow_policy policy,
+        const std::chrono::duration<Rep, Period>& deadline
+    ) {
+        start_consuming(consumer_queue<>::create(capacity, policy, deadline));
+    }
+    /**
+     * Start consuming messages on a pool of worker threads.
+     *
+     * Rather than placing incoming messages into a queue to be read by
+     * the application, this sends them to a handler that runs on a number
+     * of worker threads. Each message is hashed by a key, normally its
+     * topic, onto one of the workers, so that messages with the same key
+     * are handled in order, while those with different keys are handled
+     * in parallel.
+     * @par
+     * This replaces the consumer queue, so the `consume_...()` functions
+     * can not be used. Connection events are only reported through the
+     * callbacks and handlers. The workers are stopped by
+     * @ref stop_consuming().
+     *
+     * @param nWorkers The number of worker threads.
+     * @param handler The handler for the incoming messages.
+     * @param opts Options for the workers, such as the function to get the
+     *  		   key of a message, and the CPU affinity and names of the
+     *  		   threads.
+     */
+    void start_consuming(
+        size_t nWorkers, message_handler handler,
+        const dispatch_options& opts = dispatch_options{}
+    );
     /**
      * Stop consuming messages.
      *
@@ -825,6 +1092,58 @@ public:
     std::size_t consumer_queue_size() const override {
         return (que_) ? que_->size() : 0;
     }
+    /**
+     * Gets the number of events that the consumer queue discarded because
+     * it was full.
+     * @return The number of events dropped due to overflow.
+     */
+    std::size_t consumer_queue_dropped() const { return (que_) ? que_->dropped() : 0; }
+    /**
+     * Gets the total size of the events in the consumer queue, in bytes.
+     * This is only kept if the queue was given a byte capacity.
+     * @return The total size of the events in the queue, in bytes.
+     */
+    std::size_t consumer_queue_bytes() const { return (que_) ? que_->size_bytes() : 0; }
+    /**
+     * Turns the statistics for the consumer queue on or off.
+     * They are off by default, and are reset when the consumer is
+     * restarted.
+     * @param on Whether the consumer queue should keep statistics.
+     */
+    void enable_consumer_queue_stats(bool on = true) {
+        if (que_) que_->enable_stats(on);
+    }
+    /**
+     * Gets the statistics for the consumer queue.
+     * These include the number of events that passed through the queue,
+     * its high-water depth, the time the client spent blocked putting
+     * events into it, the time the consumer spent waiting for them, and
+     * the age of the event at the head of the queue. They are read without
+     * locking the queue. Unless enabled with
+     * @ref enable_consumer_queue_stats(), only the current depth is
+     * reported.
+     * @return The statistics for the consumer queue.
+     */
+    queue_stats consumer_queue_stats() const {
+        return (que_) ? que_->stats() : queue_stats{};
+    }
+    /**
+     * Gets a file descriptor that can be polled to find out when there are
+     * events in the consumer queue.
+     * This lets an application service the consumer from an event loop,
+     * such as with `epoll`, rather than dedicating a thread to block on
+     * the queue. When the descriptor is readable, the application should
+     * drain the queue without blocking, such as with
+     * @ref try_consume_events(). It remains readable once the consumer is
+     * stopped.
+     * @par
+     * The default consumer queue supports this on Linux, using an
+     * `eventfd`. The descriptor is owned by the queue, and is invalidated
+     * when the consumer is restarted.
+     * @return The file descriptor, or -1 if the consumer is not started or
+     *  	   the queue doesn't support one.
+     */
+    int consumer_notify_fd() { return (que_) ? que_->notify_fd() : -1; }
     /**
      * Read the next client event from the queue.
      * This blocks until a new message arrives.
@@ -1024,6 +1343,102 @@ public:
         this->try_consume_message_until(&msg, absTime);
         return msg;
     }
+    /**
+     * Reads a batch of client events from the queue.
+     * This blocks until at least one event is available, then moves as
+     * many events as are in the queue, up to the requested maximum, with a
+     * single acquisition of the queue lock.
+     * If the consumer queue is closed, this returns a shutdown event.
+     * @param evts A vector to receive the events. They are appended to the
+     *  		   back of it. If the application reserves space in the
+     *  		   vector, it can be reused without any memory allocations.
+     * @param maxEvents The maximum number of events to read.
+     * @return The number of events added to the vector.
+     */
+    size_t consume_events(std::vector<event>& evts, size_t maxEvents);
+    /**
+     * Reads a batch of client events from the queue without blocking.
+     * This moves as many events as are in the queue, up to the requested
+     * maximum. It is meant to drain the queue from an event loop, when the
+     * descriptor from @ref consumer_notify_fd() becomes readable.
+     * @param evts A vector to receive the events. They are appended to the
+     *  		   back of it.
+     * @param maxEvents The maximum number of events to read.
+     * @return The number of events added to the vector. If the consumer
+     *  	   queue is closed and empty, a shutdown event is added.
+     */
+    size_t try_consume_events(std::vector<event>& evts, size_t maxEvents) {
+        return consume_events(evts, maxEvents, std::chrono::nanoseconds{0});
+    }
+    /**
+     * Reads a batch of client events from the queue, waiting a limited
+     * time for the first one to arrive.
+     * @param evts A vector to receive the events. They are appended to the
+     *  		   back of it.
+     * @param maxEvents The maximum number of events to read.
+     * @param relTime The maximum amount of time to wait for an event.
+     * @return The number of events added to the vector, which is zero on
+     *  	   timeout.
+     */
+    template <typename Rep, class Period>
+    size_t consume_events(
+        std::vector<event>& evts, size_t maxEvents,
+        const std::chrono::duration<Rep, Period>& relTime
+    ) {
+        if (!que_)
+            throw mqtt::exception(-1, "Consumer not started");
+
+        if (maxEvents == 0)
+            return 0;
+
+        auto n = que_->try_get_n_for(evts, maxEvents, relTime);
+        if (n == 0 && que_->done()) {
+            evts.emplace_back(shutdown_event{});
+            n = 1;
+        }
+        return n;
+    }
+    /**
+     * Reads a batch of messages from the queue.
+     * This blocks until at least one message arrives or until a disconnect
+     * or shutdown occurs. Like consume_message(), any type of disconnect
+     * is reported as an empty message pointer, in its place in the
+     * sequence of messages, and 'connected' events are ignored.
+     * @param msgs A vector to receive the messages. They are appended to
+     *  		   the back of it.
+     * @param maxMsgs The maximum number of messages to read.
+     * @return The number of messages added to the vector.
+     */
+    size_t consume_messages(std::vector<const_message_ptr>& msgs, size_t maxMsgs);
+    /**
+     * Reads a batch of messages from the queue, waiting a limited time for
+     * the first one to arrive.
+     * @param msgs A vector to receive the messages. They are appended to
+     *  		   the back of it.
+     * @param maxMsgs The maximum number of messages to read.
+     * @param relTime The maximum amount of time to wait for a message.
+     * @return The number of messages added to the vector, which is zero on
+     *  	   timeout.
+     */
+    template <typename Rep, class Period>
+    size_t consume_messages(
+        std::vector<const_message_ptr>& msgs, size_t maxMsgs,
+        const std::chrono::duration<Rep, Period>& relTime
+    ) {
+        auto absTime = std::chrono::steady_clock::now() + relTime;
+
+        auto& evts = event_buffer();
+
+        size_t n = 0;
+        while (n == 0) {
+            auto remaining = absTime - std::chrono::steady_clock::now();
+            if (consume_events(evts, maxMsgs, remaining) == 0)
+                break;
+            n = events_to_messages(evts, msgs);
+            evts.clear();
+        }
+        return n;
+    }
 };
 
 /** Smart/shared pointer to an asynchronous MQTT client object */
@@ -446,6 +446,33 @@ maked      * @param props The MQTT v5 properties.
     ) {
         return cli_.try_consume_message_until(msg, absTime);
     }
+    /**
+     * Reads a batch of messages from the queue.
+     * This blocks until at least one message arrives.
+     * @param msgs A vector to receive the messages. They are appended to
+     *  		   the back of it.
+     * @param maxMsgs The maximum number of messages to read.
+     * @return The number of messages added to the vector.
+     */
+    size_t consume_messages(std::vector<const_message_ptr>& msgs, size_t maxMsgs) {
+        return cli_.consume_messages(msgs, maxMsgs);
+    }
+    /**
+     * Reads a batch of messages from the queue, waiting a limited time for
+     * the first one to arrive.
+     * @param msgs A vector to receive the messages.
+     * @param maxMsgs The maximum number of messages to read.
+     * @param relTime The maximum amount of time to wait for a message.
+     * @return The number of messages added to the vector, which is zero on
+     *  	   timeout.
+     */
+    template <typename Rep, class Period>
+    size_t consume_messages(
+        std::vector<const_message_ptr>& msgs, size_t maxMsgs,
+        const std::chrono::duration<Rep, Period>& relTime
+    ) {
+        return cli_.consume_messages(msgs, maxMsgs, relTime);
+    }
 };
 
 /** Smart/shared pointer to an MQTT synchronous client object */
@@ -0,0 +1,223 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file clock_index.h
+/// Declaration of MQTT clock_index class
+/// @date 16-Oct-2026
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_clock_index_h
+#define __mqtt_clock_index_h
+
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "mqtt/buffer_ref.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A bounded index of topic strings, which reuses the slot of one that
+ * wasn't used recently when it is full.
+ *
+ * Each topic is given a slot number, from zero up to the capacity, which
+ * the owner of the index can use to keep its own data for the topic in a
+ * parallel array. This is the common part of the library's topic tables
+ * and caches.
+ * @par
+ * The slot to reuse is picked with the CLOCK (second chance) algorithm.
+ * Each slot has a reference bit, which is set whenever its topic is
+ * inserted or looked up. When a slot is needed, a hand sweeps around the
+ * slots, clearing the bits, until it finds a free slot, or one that wasn't
+ * used since the hand last passed. This approximates LRU without having
+ * to reorder anything on a hit.
+ * @par
+ * The index is not thread-safe.
+ *
+ * @tparam Key The type that holds the topics, either a @ref string or a
+ *  		   @ref string_ref.
+ */
+template <typename Key = string>
+class clock_index
+{
+    /** A slot in the index */
+    struct entry
+    {
+        /** The topic */
+        Key key;
+        /** Whether the slot holds a topic */
+        bool used{false};
+        /** Whether the slot was used since the clock hand last passed */
+        bool ref{false};
+    };
+
+    /** The maximum number of slots */
+    size_t cap_{0};
+    /** The slots. These never move once created. */
+    std::vector<entry> entries_;
+    /** Map of the topics to their slots. The keys refer to the slots */
+    std::unordered_map<std::string_view, size_t> index_;
+    /** The position of the clock hand */
+    size_t hand_{0};
+
+    /** Gets a view of a topic string */
+    static std::string_view view_of(const string& key) { return key; }
+    /** Gets a view of a shared topic string */
+    static std::string_view view_of(const string_ref& key) { return key.str(); }
+
+    /** Picks a slot to reuse, advancing the clock hand */
+    size_t victim() {
+        for (;;) {
+            auto& ent = entries_[hand_];
+            auto i = hand_;
+            hand_ = (hand_ + 1) % entries_.size();
+
+            if (!ent.used || !ent.ref)
+                return i;
+            ent.ref = false;
+        }
+    }
+
+public:
+    /** The slot number returned when a topic isn't in the index */
+    static constexpr size_t npos = size_t(-1);
+
+    /**
+     * Creates an index.
+     * @param capacity The maximum number of topics.
+     */
+    explicit clock_index(size_t capacity = 0) { reset(capacity); }
+    /**
+     * The index can't be copied, since it refers to its own slots.
+     */
+    clock_index(const clock_index&) = delete;
+    /**
+     * The index can't be copied.
+     */
+    clock_index& operator=(const clock_index&) = delete;
+    /**
+     * Gets the maximum number of topics.
+     * @return The maximum number of topics.
+     */
+    size_t capacity() const { return cap_; }
+    /**
+     * Gets the number of topics in the index.
+     * @return The number of topics in the index.
+     */
+    size_t size() const { return index_.size(); }
+    /**
+     * Gets the topic in a slot.
+     * @param i The slot number.
+     * @return The topic in the slot.
+     */
+    const Key& key(size_t i) const { return entries_[i].key; }
+    /**
+     * Removes all the topics.
+     */
+    void clear() {
+        index_.clear();
+        entries_.clear();
+        hand_ = 0;
+    }
+    /**
+     * Removes all the topics, and sets the maximum number of them.
+     * @param capacity The maximum number of topics.
+     */
+    void reset(size_t capacity) {
+        clear();
+        cap_ = capacity;
+
+        // The index refers to the topics in the slots, so they can't move.
+        entries_.reserve(cap_);
+        index_.reserve(cap_);
+    }
+    /**
+     * Finds the slot of a topic, without counting it as a use.
+     * @param topic The topic.
+     * @return The slot number, or @ref npos if the topic isn't in the
+     *  	   index.
+     */
+    size_t find(std::string_view topic) const {
+        auto it = index_.find(topic);
+        return (it != index_.end()) ? it->second : npos;
+    }
+    /**
+     * Finds the slot of a topic, marking it as used.
+     * @param topic The topic.
+     * @return The slot number, or @ref npos if the topic isn't in the
+     *  	   index.
+     */
+    size_t lookup(std::string_view topic) {
+        auto i = find(topic);
+        if (i != npos)
+            entries_[i].ref = true;
+        return i;
+    }
+    /**
+     * Adds a topic that isn't already in the index.
+     * If the index is full, this takes the slot of a topic that wasn't
+     * used recently. The capacity must not be zero.
+     * @param topic The topic.
+     * @return The slot number for the topic. This is either a new slot,
+     *  	   numbered one past the last, or one that was reused.
+     */
+    size_t insert(Key topic) {
+        size_t i;
+        if (entries_.size() < cap_) {
+            i = entries_.size();
+            entries_.emplace_back();
+        }
+        else {
+            i = victim();
+            if (entries_[i].used)
+                index_.erase(view_of(entries_[i].key));
+        }
+
+        auto& ent = entries_[i];
+        ent.key = std::move(topic);
+        ent.used = true;
+        ent.ref = true;
+        index_.emplace(view_of(ent.key), i);
+        return i;
+    }
+    /**
+     * Removes a topic, freeing its slot.
+     * @param topic The topic.
+     * @return @em true if the topic was in the index, @em false otherwise.
+     */
+    bool erase(std::string_view topic) {
+        auto it = index_.find(topic);
+        if (it == index_.end())
+            return false;
+
+        auto& ent = entries_[it->second];
+        index_.erase(it);
+        ent.key = Key{};
+        ent.used = false;
+        ent.ref = false;
+        return true;
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_clock_index_h
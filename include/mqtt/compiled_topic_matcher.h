@@ -0,0 +1,494 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file compiled_topic_matcher.h
+/// Declaration of MQTT compiled_topic_matcher class
+/// @date 16-Oct-2026
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_compiled_topic_matcher_h
+#define __mqtt_compiled_topic_matcher_h
+
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mqtt/topic_matcher.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A frozen, read-only collection of MQTT topic filters mapped to values,
+ * compiled for fast matching.
+ *
+ * This is for a set of subscriptions that is built once, such as at
+ * startup, and then used to match a large number of incoming topics. It
+ * can be built from a @ref topic_matcher, or from a list of filter/value
+ * pairs, but can not be modified afterward.
+ *
+ * The filters are compiled into a few flat arrays:
+ *
+ * @li A table of the states (the nodes of the filter trie), each of which
+ *     holds the index of its value, its '+' transition, and the value of
+ *     its '#' child, if any.
+ * @li An open-addressed hash table of the fields used in the filters,
+ *     which maps each one to an integer id. The text of the fields is kept
+ *     in a single string.
+ * @li An open-addressed hash table of the transitions for the exact
+ *     fields, keyed by the (state, field id) pair.
+ *
+ * Matching a topic is then a single, linear pass over its fields. For each
+ * field, the id is looked up once, and the set of active states is stepped
+ * forward through the exact and '+' transitions, collecting any '#' values
+ * along the way. This is a simulation of the automaton for the filters,
+ * which finds all the matches in the one pass, without any recursion or
+ * backtracking, and without allocating memory for typical topics.
+ * @par
+ * The results are the same as for @ref topic_matcher, but may be produced
+ * in a different order. Shared subscription filters,
+ * "$share/{group}/{filter}", are not accepted. Each constructor throws
+ * std::invalid_argument if it is given one.
+ */
+template <typename T>
+class compiled_topic_matcher
+{
+public:
+    using key_type = string;
+    using mapped_type = T;
+    using value_type = std::pair<key_type, mapped_type>;
+    using const_reference = const value_type&;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+private:
+    /** Index type for the states, values, and fields */
+    using index_type = uint32_t;
+
+    /** Index used for "none" */
+    static constexpr index_type NONE = index_type(-1);
+
+    /** A state (node) of the compiled filters */
+    struct state
+    {
+        /** The index of the value that matches at this state, if any */
+        index_type value{NONE};
+        /** The state reached by a '+' wildcard, if any */
+        index_type plus{NONE};
+        /** The index of the value for a '#' wildcard at this state, if any */
+        index_type hash{NONE};
+    };
+
+    /** The location of a field in the text of all the fields */
+    struct field_loc
+    {
+        index_type off;
+        index_type len;
+    };
+
+    /** An exact-field transition between states */
+    struct transition
+    {
+        index_type from{NONE};
+        index_type field{NONE};
+        index_type to{NONE};
+    };
+
+    /**
+     * A small set of states used while matching, which only goes to the
+     * heap if there are a lot of states active at once.
+     */
+    class state_set
+    {
+        static constexpr size_t N_INLINE = 32;
+
+        index_type buf_[N_INLINE];
+        size_t n_{0};
+        std::vector<index_type> more_;
+
+    public:
+        bool empty() const { return n_ == 0; }
+        size_t size() const { return n_; }
+        void clear() {
+            n_ = 0;
+            more_.clear();
+        }
+        void push(index_type s) {
+            if (n_ < N_INLINE)
+                buf_[n_] = s;
+            else
+                more_.push_back(s);
+            ++n_;
+        }
+        index_type operator[](size_t i) const {
+            return (i < N_INLINE) ? buf_[i] : more_[i - N_INLINE];
+        }
+    };
+
+    /** The states. The start state is at index zero. */
+    std::vector<state> states_;
+    /** The values, in the order they were added */
+    std::vector<value_type> values_;
+    /** The text of all the fields, back to back */
+    string fieldText_;
+    /** The location of each field in the text, by id */
+    std::vector<field_loc> fields_;
+    /** Hash table of the field ids. Empty slots are NONE */
+    std::vector<index_type> fieldTable_;
+    /** Hash table of the exact transitions */
+    std::vector<transition> transTable_;
+
+    /** Hash for the pair of a state and a field */
+    static size_t trans_hash(index_type from, index_type field) {
+        auto key = (uint64_t(from) << 32) | field;
+        key ^= key >> 33;
+        key *= 0xFF51AFD7ED558CCDull;
+        key ^= key >> 33;
+        return size_t(key);
+    }
+    /** Gets the size of an open-addressed table for n items */
+    static size_t table_size(size_t n) {
+        size_t sz = 8;
+        while (sz < 2 * n) sz <<= 1;
+        return sz;
+    }
+    /** Gets the text of the field with the specified id */
+    std::string_view field_text(index_type id) const {
+        const auto& loc = fields_[id];
+        return std::string_view{fieldText_}.substr(loc.off, loc.len);
+    }
+    /** Gets the id of a field, or NONE if it isn't used in any filter. */
+    index_type field_id(std::string_view field) const {
+        const size_t mask = fieldTable_.size() - 1;
+        for (size_t i = std::hash<std::string_view>{}(field) & mask;; i = (i + 1) & mask) {
+            auto id = fieldTable_[i];
+            if (id == NONE || field_text(id) == field)
+                return id;
+        }
+    }
+    /** Gets the state reached from another on an exact field, if any */
+    index_type next_state(index_type from, index_type field) const {
+        const size_t mask = transTable_.size() - 1;
+        for (size_t i = trans_hash(from, field) & mask;; i = (i + 1) & mask) {
+            const auto& tr = transTable_[i];
+            if (tr.from == NONE)
+                return NONE;
+            if (tr.from == from && tr.field == field)
+                return tr.to;
+        }
+    }
+    /**
+     * Splits off the next field of a topic or filter.
+     * @param s The remaining part of the topic. On return this is what
+     *  		follows the next separator.
+     * @param more Set @em true if there are more fields after this one.
+     * @return The next field.
+     */
+    static std::string_view next_field(std::string_view& s, bool& more) {
+        auto pos = s.find('/');
+        auto field = s.substr(0, pos);
+        more = (pos != std::string_view::npos);
+        s = more ? s.substr(pos + 1) : std::string_view{};
+        return field;
+    }
+
+    /**
+     * Compiles the values into the tables.
+     * The filters are first built into a simple trie, which is then
+     * flattened into the hash tables.
+     */
+    void compile() {
+        for (const auto& val : values_) {
+            if (topic_filter::is_shared(val.first))
+                throw std::invalid_argument("Shared subscription filters are not supported");
+        }
+
+        // The field ids, while building
+        std::unordered_map<string, index_type> ids;
+        // The exact transitions, while building
+        std::unordered_map<uint64_t, index_type> trans;
+
+        states_.emplace_back();
+
+        // Later duplicates of a filter replace the earlier ones
+        std::vector<value_type> vals;
+        std::swap(vals, values_);
+
+        for (auto& val : vals) {
+            std::string_view filter{val.first};
+            index_type s = 0;
+            bool more = true, isHash = false;
+
+            while (more) {
+                auto field = next_field(filter, more);
+                if (field == "#") {
+                    // By definition, a '#' is a terminating leaf
+                    isHash = true;
+                    break;
+                }
+                if (field == "+") {
+                    if (states_[s].plus == NONE) {
+                        states_.emplace_back();
+                        states_[s].plus = index_type(states_.size() - 1);
+                    }
+                    s = states_[s].plus;
+                }
+                else {
+                    auto it = ids.find(string{field});
+                    if (it == ids.end()) {
+                        auto id = index_type(fields_.size());
+                        fields_.push_back(
+                            {index_type(fieldText_.size()), index_type(field.size())}
+                        );
+                        fieldText_.append(field);
+                        it = ids.emplace(string{field}, id).first;
+                    }
+                    auto key = (uint64_t(s) << 32) | it->second;
+                    auto tr = trans.find(key);
+                    if (tr == trans.end()) {
+                        states_.emplace_back();
+                        tr = trans.emplace(key, index_type(states_.size() - 1)).first;
+                    }
+                    s = tr->second;
+                }
+            }
+
+            // A '#' in the middle of a filter can never match anything
+            if (isHash && more)
+                continue;
+
+            auto& slot = isHash ? states_[s].hash : states_[s].value;
+            if (slot != NONE) {
+                values_[slot] = std::move(val);
+            }
+            else {
+                slot = index_type(values_.size());
+                values_.push_back(std::move(val));
+            }
+        }
+
+        // Flatten the field ids into an open-addressed table
+
+        fieldTable_.assign(table_size(fields_.size()), NONE);
+        for (index_type id = 0; id < fields_.size(); ++id) {
+            const size_t mask = fieldTable_.size() - 1;
+            auto i = std::hash<std::string_view>{}(field_text(id)) & mask;
+            while (fieldTable_[i] != NONE) i = (i + 1) & mask;
+            fieldTable_[i] = id;
+        }
+
+        // ...and the same for the transitions
+
+        transTable_.assign(table_size(trans.size()), transition{});
+        for (const auto& tr : trans) {
+            auto from = index_type(tr.first >> 32), field = index_type(tr.first);
+            const size_t mask = transTable_.size() - 1;
+            auto i = trans_hash(from, field) & mask;
+            while (transTable_[i].from != NONE) i = (i + 1) & mask;
+            transTable_[i] = transition{from, field, tr.second};
+        }
+    }
+
+public:
+    /**
+     * Creates a collection from a list of key/value pairs.
+     * @param lst The list of key/value pairs to populate the collection.
+     */
+    compiled_topic_matcher(std::initializer_list<value_type> lst) : values_{lst} {
+        compile();
+    }
+    /**
+     * Creates a collection from a range of key/value pairs.
+     * @param first The first item in the range.
+     * @param last One past the last item in the range.
+     */
+    template <class InputIt>
+    compiled_topic_matcher(InputIt first, InputIt last) : values_(first, last) {
+        compile();
+    }
+    /**
+     * Creates a collection from a vector of key/value pairs.
+     * @param vals The key/value pairs to populate the collection.
+     */
+    explicit compiled_topic_matcher(std::vector<value_type> vals) : values_{std::move(vals)} {
+        compile();
+    }
+    /**
+     * Creates a collection from the contents of a topic matcher.
+     * @param tm The topic matcher.
+     */
+    explicit compiled_topic_matcher(const topic_matcher<T>& tm) {
+        for (auto it = tm.cbegin(); it != tm.cend(); ++it) values_.push_back(*it);
+        compile();
+    }
+    /**
+     * Determines if the collection is empty.
+     * @return @em true if the collection is empty, @em false if it contains
+     *         any filters.
+     */
+    bool empty() const { return values_.empty(); }
+    /**
+     * Gets the number of filters in the collection.
+     * @return The number of filters in the collection.
+     */
+    size_t size() const { return values_.size(); }
+    /**
+     * Gets the number of states in the compiled collection.
+     * @return The number of states in the compiled collection.
+     */
+    size_t state_count() const { return states_.size(); }
+    /**
+     * Gets a const iterator to the full collection of filters.
+     * @return A const iterator to the full collection of filters.
+     */
+    const_iterator begin() const { return values_.cbegin(); }
+    /**
+     * Gets a const iterator to the end of the collection of filters.
+     * @return A const iterator to the end of the collection of filters.
+     */
+    const_iterator end() const { return values_.cend(); }
+    /**
+     * Gets a const iterator to the full collection of filters.
+     * @return A const iterator to the full collection of filters.
+     */
+    const_iterator cbegin() const { return values_.cbegin(); }
+    /**
+     * Gets a const iterator to the end of the collection of filters.
+     * @return A const iterator to the end of the collection of filters.
+     */
+    const_iterator cend() const { return values_.cend(); }
+    /**
+     * Gets an iterator to the value at the requested key.
+     * @param filter The topic filter entry to find.
+     * @return An iterator to the value if found, @em end() if not found.
+     */
+    const_iterator find(std::string_view filter) const {
+        index_type s = 0;
+        bool more = true;
+
+        while (more) {
+            auto field = next_field(filter, more);
+            index_type i = NONE;
+
+            if (field == "#") {
+                if (!more && (i = states_[s].hash) != NONE)
+                    return values_.cbegin() + i;
+                return end();
+            }
+            else if (field == "+") {
+                s = states_[s].plus;
+            }
+            else {
+                auto id = field_id(field);
+                s = (id == NONE) ? NONE : next_state(s, id);
+            }
+            if (s == NONE)
+                return end();
+        }
+        return (states_[s].value != NONE) ? (values_.cbegin() + states_[s].value) : end();
+    }
+    /**
+     * Finds all the values that match the topic.
+     * @param topic The topic to search for matches.
+     * @param out A vector to receive pointers to the matching values. They
+     *  		  are appended to the back, in no particular order.
+     * @return The number of matches found.
+     */
+    size_t matches(std::string_view topic, std::vector<const value_type*>& out) const {
+        state_set sets[2];
+        auto *cur = &sets[0], *nxt = &sets[1];
+
+        const auto n = out.size();
+        bool more = true, first = true;
+
+        cur->push(0);
+
+        while (more) {
+            auto field = next_field(topic, more);
+            auto id = field_id(field);
+
+            // Topics starting with '$' don't match wildcards in the first field
+            // MQTT v5 Spec, Section 4.7.2:
+            // https://docs.oasis-open.org/mqtt/mqtt/v5.0/os/mqtt-v5.0-os.html#_Toc3901246
+
+            bool wild = !first || field.empty() || field[0] != '$';
+            first = false;
+
+            nxt->clear();
+            for (size_t i = 0; i < cur->size(); ++i) {
+                const auto s = (*cur)[i];
+                const auto& st = states_[s];
+
+                if (wild) {
+                    if (st.hash != NONE)
+                        out.push_back(&values_[st.hash]);
+                    if (st.plus != NONE)
+                        nxt->push(st.plus);
+                }
+                if (id != NONE) {
+                    auto to = next_state(s, id);
+                    if (to != NONE)
+                        nxt->push(to);
+                }
+            }
+
+            std::swap(cur, nxt);
+            if (cur->empty())
+                return out.size() - n;
+        }
+
+        for (size_t i = 0; i < cur->size(); ++i) {
+            auto val = states_[(*cur)[i]].value;
+            if (val != NONE)
+                out.push_back(&values_[val]);
+        }
+        return out.size() - n;
+    }
+    /**
+     * Finds all the values that match the topic.
+     * @param topic The topic to search for matches.
+     * @return Pointers to the matching values, in no particular order.
+     */
+    std::vector<const value_type*> matches(std::string_view topic) const {
+        std::vector<const value_type*> out;
+        matches(topic, out);
+        return out;
+    }
+    /**
+     * Determines if there are any matches for the specified topic.
+     * @param topic The topic to search for matches.
+     * @return Whether there are any matches for the topic in the
+     *         collection.
+     */
+    bool has_match(std::string_view topic) const {
+        std::vector<const value_type*> out;
+        return matches(topic, out) != 0;
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_compiled_topic_matcher_h
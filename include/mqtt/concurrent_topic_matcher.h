@@ -0,0 +1,289 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file concurrent_topic_matcher.h
+/// Declaration of MQTT concurrent_topic_matcher class
+/// @date 16-Oct-2026
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_concurrent_topic_matcher_h
+#define __mqtt_concurrent_topic_matcher_h
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "mqtt/rcu_ptr.h"
+#include "mqtt/topic_matcher.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A thread-safe collection of MQTT topic filters mapped to values, for
+ * when the filters are matched from many threads, but rarely change.
+ *
+ * This uses a read-copy-update (RCU) scheme. The current contents are kept
+ * as an immutable @ref topic_matcher snapshot, held by an @ref rcu_ptr.
+ * Readers match against the current snapshot without blocking each other
+ * or the writers.
+ * @par
+ * The writers, `insert()`, `remove()`, `prune()`, and `update()`, are
+ * serialized with a mutex. Each one copies the current snapshot, makes its
+ * changes to the copy, and then publishes the copy as the new snapshot.
+ * An old snapshot is released when the last reader that holds it lets it
+ * go. Since every change copies the collection, this is meant for sets of
+ * filters that change far less often than they're matched. Use `update()`
+ * to make a number of changes at once.
+ * @par
+ * Getting the snapshot with `snapshot()` is an atomic load of a shared
+ * pointer. With the common standard libraries, that takes a lock from a
+ * shared pool, and touches the reference count that all the readers share.
+ * The matching functions, `for_each_match()` and `has_match()`, avoid that
+ * by using a snapshot cached by the calling thread, and only check an
+ * atomic version number on each match, so, until the filters change, the
+ * matching threads take no lock and never write to any shared memory. A
+ * @ref reader does the same, with a reference held by the caller.
+ *
+ * @code
+ * concurrent_topic_matcher<handler> handlers;
+ * ...
+ * // In each dispatch thread:
+ * auto rdr = handlers.get_reader();
+ * while (auto msg = cli.consume_message()) {
+ *     rdr.for_each_match(msg->get_topic(), [&](auto& val) { val.second(msg); });
+ * }
+ * @endcode
+ */
+template <typename T>
+class concurrent_topic_matcher
+{
+public:
+    /** The type of the underlying, single-threaded, collection */
+    using matcher_type = topic_matcher<T>;
+    /** A pointer to an immutable snapshot of the collection */
+    using snapshot_ptr = std::shared_ptr<const matcher_type>;
+
+    using key_type = typename matcher_type::key_type;
+    using mapped_type = typename matcher_type::mapped_type;
+    using value_type = typename matcher_type::value_type;
+    using mapped_ptr = typename matcher_type::mapped_ptr;
+
+private:
+    /** The current snapshot, and its version */
+    rcu_ptr<matcher_type> snap_;
+    /** Lock to serialize the writers */
+    std::mutex writeLock_;
+
+    /** Makes a copy of a collection */
+    static std::unique_ptr<matcher_type> clone(const matcher_type& tm) {
+        auto copy = std::make_unique<matcher_type>();
+        for (auto it = tm.cbegin(); it != tm.cend(); ++it) copy->insert(*it);
+        return copy;
+    }
+
+    /** Publishes a new snapshot. Must be called with the write lock held. */
+    void publish(std::unique_ptr<matcher_type> tm) {
+        snap_.store(snapshot_ptr{std::move(tm)});
+    }
+
+public:
+    /**
+     * A handle for a thread to match topics against the collection.
+     *
+     * This keeps a reference to the latest snapshot that it saw, and only
+     * reloads it when the version of the collection changes. The reader
+     * itself is not thread-safe; each thread should get its own.
+     */
+    class reader
+    {
+        /** The collection */
+        const concurrent_topic_matcher* ctm_;
+        /** The snapshot in use */
+        snapshot_ptr snap_;
+        /** The version of the snapshot in use */
+        uint64_t ver_;
+
+        friend class concurrent_topic_matcher;
+
+        reader(const concurrent_topic_matcher* ctm) : ctm_{ctm} {
+            // Get the version first, so a change in between isn't missed
+            ver_ = ctm->version();
+            snap_ = ctm->snapshot();
+        }
+
+    public:
+        /**
+         * Gets the latest snapshot, reloading it if the collection changed.
+         * @return A reference to the latest snapshot. This is valid until
+         *  	   the next call into the reader.
+         */
+        const matcher_type& current() {
+            auto ver = ctm_->version();
+            if (ver != ver_) {
+                snap_ = ctm_->snapshot();
+                ver_ = ver;
+            }
+            return *snap_;
+        }
+        /**
+         * Calls a function for each value that matches the topic.
+         * @param topic The topic to search for matches.
+         * @param fn The function to call, as `fn(const value_type&)`.
+         * @return The number of matches.
+         */
+        template <typename Fn>
+        size_t for_each_match(const string& topic, Fn fn) {
+            const auto& tm = current();
+            size_t n = 0;
+            auto end = tm.matches_cend();
+            for (auto it = tm.matches(std::string_view{topic}); it != end; ++it, ++n) fn(*it);
+            return n;
+        }
+        /**
+         * Determines if there are any matches for the specified topic.
+         * @param topic The topic to search for matches.
+         * @return Whether there are any matches for the topic.
+         */
+        bool has_match(const string& topic) {
+            const auto& tm = current();
+            return tm.matches(std::string_view{topic}) != tm.matches_cend();
+        }
+    };
+
+    /**
+     * Creates  new, empty collection.
+     */
+    concurrent_topic_matcher() : snap_{std::make_shared<const matcher_type>()} {}
+    /**
+     * Creates a new collection with a list of key/value pairs.
+     * @param lst The list of key/value pairs to populate the collection.
+     */
+    concurrent_topic_matcher(std::initializer_list<value_type> lst)
+        : snap_{std::make_shared<const matcher_type>(lst)} {}
+    /**
+     * Gets the current snapshot of the collection.
+     * The snapshot is immutable, and remains valid for as long as the
+     * caller holds it, even if the collection is changed.
+     * @return A pointer to the current snapshot of the collection.
+     */
+    snapshot_ptr snapshot() const { return snap_.load(); }
+    /**
+     * Gets the version of the collection.
+     * This is incremented each time the collection is changed.
+     * @return The version of the collection.
+     */
+    uint64_t version() const { return snap_.version(); }
+    /**
+     * Gets a reader to match topics from the calling thread.
+     * @return A reader for the collection.
+     */
+    reader get_reader() const { return reader{this}; }
+    /**
+     * Determines if the collection is empty.
+     * @return @em true if the collection is empty, @em false if it contains
+     *         any filters.
+     */
+    bool empty() const { return snapshot()->empty(); }
+    /**
+     * Makes a number of changes to the collection at once.
+     * The function is called with a copy of the current contents, which it
+     * can modify as needed, and which is then published as the new
+     * snapshot. If the function throws, the collection is not changed.
+     * @param fn The function to modify the collection, as
+     *  		 `fn(matcher_type&)`.
+     */
+    template <typename Fn>
+    void update(Fn fn) {
+        std::lock_guard<std::mutex> lk{writeLock_};
+        auto tm = clone(*snapshot());
+        fn(*tm);
+        publish(std::move(tm));
+    }
+    /**
+     * Inserts a new key/value pair into the collection.
+     * @param val The value to place in the collection.
+     */
+    void insert(value_type&& val) {
+        update([&](matcher_type& tm) { tm.insert(std::move(val)); });
+    }
+    /**
+     * Inserts a new value into the collection.
+     * @param val The value to place in the collection.
+     */
+    void insert(const value_type& val) {
+        update([&](matcher_type& tm) { tm.insert(val); });
+    }
+    /**
+     * Removes an entry from the collection.
+     * @param filter The topic filter to remove.
+     * @return A unique pointer to the value, if any.
+     */
+    mapped_ptr remove(const key_type& filter) {
+        mapped_ptr val;
+        update([&](matcher_type& tm) { val = tm.remove(filter); });
+        return val;
+    }
+    /**
+     * Removes the empty nodes in the collection.
+     * Since each change makes a fresh copy of the collection, this is
+     * rarely needed.
+     */
+    void prune() {
+        update([](matcher_type& tm) { tm.prune(); });
+    }
+    /**
+     * Calls a function for each value that matches the topic, using the
+     * current snapshot.
+     * This uses the calling thread's cached snapshot, if it's up to date.
+     * The function can safely change the collection, or match against it
+     * again.
+     * @param topic The topic to search for matches.
+     * @param fn The function to call, as `fn(const value_type&)`.
+     * @return The number of matches.
+     */
+    template <typename Fn>
+    size_t for_each_match(const string& topic, Fn fn) const {
+        return snap_.with_local([&](const matcher_type& tm) {
+            size_t n = 0;
+            auto end = tm.matches_cend();
+            for (auto it = tm.matches(std::string_view{topic}); it != end; ++it, ++n) fn(*it);
+            return n;
+        });
+    }
+    /**
+     * Determines if there are any matches for the specified topic.
+     * @param topic The topic to search for matches.
+     * @return Whether there are any matches for the topic in the
+     *         collection.
+     */
+    bool has_match(const string& topic) const {
+        return snap_.with_local([&](const matcher_type& tm) {
+            return tm.matches(std::string_view{topic}) != tm.matches_cend();
+        });
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_concurrent_topic_matcher_h
@@ -0,0 +1,222 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file conflating_queue.h
+/// Declaration of a container for 'thread_queue' that conflates items with
+/// the same key, so that only the latest value for each key is kept.
+/// @date 16-Oct-2026
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_conflating_queue_h
+#define __mqtt_conflating_queue_h
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "mqtt/event.h"
+#include "mqtt/thread_queue.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A FIFO container that conflates items with the same key.
+ *
+ * When an item is pushed onto the back of the container while another item
+ * with the same key is still in the container, the new item replaces the
+ * old one in place, keeping the old item's position in the sequence. So
+ * the container holds at most one item per key, which is always the latest
+ * one that was pushed. Items without a key are never conflated.
+ * @par
+ * This is meant to be used as the underlying container of a
+ * @ref thread_queue, which only needs the subset of the `std::deque` API
+ * implemented here. Replacing an item is O(1) and does not allocate. The
+ * container keeps a copy of the key of each item it holds.
+ *
+ * @tparam T The type of the items in the container.
+ * @tparam KeyOf A function object type that gets the key of an item as a
+ *  			 `std::optional<std::string_view>`.
+ */
+template <typename T, class KeyOf>
+class conflating_deque
+{
+public:
+    /** The type of items in the container */
+    using value_type = T;
+    /** The type used to specify number of items in the container. */
+    using size_type = typename std::deque<T>::size_type;
+    /** Reference to an item */
+    using reference = T&;
+    /** Const reference to an item */
+    using const_reference = const T&;
+
+private:
+    /** The items, in order */
+    std::deque<T> que_;
+    /**
+     * The keys of the items, in the same order. The container keeps its
+     * own copy since an item may be moved out of the front before it is
+     * popped.
+     */
+    std::deque<std::optional<string>> keys_;
+    /** The absolute sequence number of the item at the front */
+    uint64_t head_{0};
+    /** Map of each key to the sequence number of its item */
+    std::unordered_map<std::string_view, uint64_t> index_;
+    /** The number of items that were replaced by newer ones */
+    size_type conflated_{0};
+
+    /** Gets the key of an item, if it has one */
+    static std::optional<std::string_view> key_of(const T& val) { return KeyOf{}(val); }
+
+public:
+    /**
+     * Determine if the container is empty.
+     * @return @em true if there are no items in the container.
+     */
+    bool empty() const { return que_.empty(); }
+    /**
+     * Gets the number of items in the container.
+     * @return The number of items in the container.
+     */
+    size_type size() const { return que_.size(); }
+    /**
+     * Gets the number of items that were replaced by newer items with the
+     * same key, since the container was created.
+     * @return The number of conflated items.
+     */
+    size_type conflated() const { return conflated_; }
+    /**
+     * Gets a reference to the item at the front of the container.
+     * @return A reference to the item at the front of the container.
+     */
+    reference front() { return que_.front(); }
+    /**
+     * Gets a const reference to the item at the front of the container.
+     * @return A const reference to the item at the front of the container.
+     */
+    const_reference front() const { return que_.front(); }
+    /**
+     * Gets a reference to the item at the back of the container.
+     * @return A reference to the item at the back of the container.
+     */
+    reference back() { return que_.back(); }
+    /**
+     * Gets a const reference to the item at the back of the container.
+     * @return A const reference to the item at the back of the container.
+     */
+    const_reference back() const { return que_.back(); }
+    /**
+     * Adds an item to the back of the container, or replaces the item in
+     * the container that has the same key.
+     * @param val The item to add. If it replaced an item already in the
+     *  		  container, the old item is swapped back into this
+     *  		  argument.
+     * @return A reference to the item in the container.
+     */
+    reference emplace_back(T&& val) {
+        auto key = key_of(val);
+        if (key) {
+            auto it = index_.find(*key);
+            if (it != index_.end()) {
+                auto& slot = que_[size_type(it->second - head_)];
+                using std::swap;
+                swap(slot, val);
+                ++conflated_;
+                return slot;
+            }
+        }
+
+        que_.push_back(std::move(val));
+        if (key) {
+            keys_.emplace_back(string{*key});
+            index_.emplace(std::string_view{*keys_.back()}, head_ + que_.size() - 1);
+        }
+        else {
+            keys_.emplace_back();
+        }
+        return que_.back();
+    }
+    /**
+     * Adds an item to the back of the container, or replaces the item in
+     * the container that has the same key.
+     * @param val The item to add.
+     */
+    void push_back(T&& val) { emplace_back(std::move(val)); }
+    /**
+     * Removes the item at the front of the container.
+     */
+    void pop_front() {
+        if (const auto& key = keys_.front())
+            index_.erase(std::string_view{*key});
+        keys_.pop_front();
+        que_.pop_front();
+        ++head_;
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Function object to get the topic of a message event, to use as the key
+ * of a @ref conflating_deque of events.
+ * Events other than messages have no key, so they are never conflated.
+ */
+struct event_topic_key
+{
+    /**
+     * Gets the topic of a message event.
+     * @param evt The event.
+     * @return The topic, if the event is a message, otherwise nothing.
+     */
+    std::optional<std::string_view> operator()(const event& evt) const {
+        auto pmsg = evt.get_message_if();
+        if (pmsg && *pmsg)
+            return std::string_view{(*pmsg)->get_topic()};
+        return std::nullopt;
+    }
+};
+
+/**
+ * A thread-safe, conflating queue of client events.
+ *
+ * A message that arrives while there is still an undelivered message for
+ * the same topic in the queue replaces that message, keeping its place in
+ * the queue. Connect and disconnect events are always queued in order.
+ * This can be used as the client consumer queue when only the latest value
+ * for each topic matters, so that a slow consumer skips stale messages
+ * rather than working through a backlog:
+ *
+ * @code
+ * cli.start_consuming(consumer_queue<conflating_event_queue>::create());
+ * @endcode
+ *
+ * Note that if the queue is given a capacity, a put() blocks when the
+ * queue is full, even if the new message would replace one in the queue.
+ */
+using conflating_event_queue = thread_queue<event, conflating_deque<event, event_topic_key>>;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_conflating_queue_h
@@ -0,0 +1,509 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file consumer_queue.h
+/// Declaration of the interface for the queue used by the client's event
+/// consumer, and an adapter to use any of the library's queues as one.
+/// @date 16-Oct-2026
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_consumer_queue_h
+#define __mqtt_consumer_queue_h
+
+#include <chrono>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "mqtt/event.h"
+#include "mqtt/thread_queue.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Gets the approximate size of a message, in bytes, as the size of its
+ * payload plus its topic.
+ * This can be used as the size function for the byte capacity of a queue
+ * of messages.
+ * @param msg The message.
+ * @return The size of the message, in bytes, or zero for a null message.
+ */
+inline std::size_t message_bytes(const const_message_ptr& msg) {
+    return msg ? (msg->get_payload().size() + msg->get_topic().size()) : 0;
+}
+
+/**
+ * Gets the approximate size of an event, in bytes.
+ * For a message event this is the size of the message payload plus its
+ * topic. Other events are counted as zero.
+ * This can be used as the size function for the byte capacity of a queue
+ * of events, like the client's consumer queue:
+ *
+ * @code
+ * auto que = std::make_unique<consumer_queue<>>();
+ * que->queue().byte_capacity(64 * 1024 * 1024, event_bytes);
+ * cli.start_consuming(std::move(que));
+ * @endcode
+ *
+ * @param evt The event.
+ * @return The size of the event, in bytes.
+ */
+inline std::size_t event_bytes(const event& evt) {
+    auto pmsg = evt.get_message_if();
+    return pmsg ? message_bytes(*pmsg) : 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Interface for the queue that passes events from the client to the
+ * application's consumer.
+ *
+ * The async_client pushes events into the queue from the callback thread
+ * of the underlying C library, and the application pulls them out with the
+ * client's `consume_event()` and `consume_message()` family of functions.
+ * @par
+ * This allows the application to choose the type of queue used by the
+ * consumer when it starts consuming. Normally any of the library's queues
+ * would be installed with the @ref consumer_queue adapter.
+ */
+class iconsumer_queue
+{
+public:
+    /** The type of items to be held in the queue. */
+    using value_type = event;
+    /** The type used to specify number of items in the container. */
+    using size_type = std::size_t;
+
+    /**
+     * Virtual destructor.
+     */
+    virtual ~iconsumer_queue() {}
+    /**
+     * Determine if the queue is empty.
+     * @return @em true if there are no elements in the queue, @em false if
+     *  	   there are any items in the queue.
+     */
+    virtual bool empty() const = 0;
+    /**
+     * Gets the capacity of the queue.
+     * @return The maximum number of elements before the queue is full.
+     */
+    virtual size_type capacity() const = 0;
+    /**
+     * Gets the number of items in the queue.
+     * @return The number of items in the queue.
+     */
+    virtual size_type size() const = 0;
+    /**
+     * Gets the total size of the events in the queue, in bytes.
+     * This is only kept by queues that have a byte capacity.
+     * @return The total size of the events in the queue, in bytes.
+     */
+    virtual std::size_t size_bytes() const { return 0; }
+    /**
+     * Close the queue.
+     * Once closed, the queue will not accept any new items, but receievers
+     * will still be able to get any remaining items out of the queue until
+     * it is empty.
+     */
+    virtual void close() = 0;
+    /**
+     * Determines if the queue is closed.
+     * @return @em true if the queue is closed, @false otherwise.
+     */
+    virtual bool closed() const = 0;
+    /**
+     * Determines if all possible operations are done on the queue.
+     * @return @true if the queue is closed and empty, @em false otherwise.
+     */
+    virtual bool done() const = 0;
+    /**
+     * Clear the contents of the queue.
+     * This discards all items in the queue.
+     */
+    virtual void clear() = 0;
+    /**
+     * Gets the number of items that the queue discarded because it was
+     * full.
+     * This is only non-zero for a bounded queue with an overflow policy
+     * that drops items.
+     * @return The number of items dropped due to overflow.
+     */
+    virtual size_type dropped() const { return 0; }
+    /**
+     * Gets a file descriptor that can be polled to find out when there are
+     * events in the queue.
+     * The descriptor is owned by the queue, and is readable while there
+     * are events in the queue, and after the queue is closed.
+     * @return The file descriptor, or -1 if the queue does not support
+     *  	   one.
+     */
+    virtual int notify_fd() { return -1; }
+    /**
+     * Turns the statistics for the queue on or off, if the queue supports
+     * them.
+     * @param on Whether to keep statistics.
+     */
+    virtual void enable_stats(bool on = true) { (void)on; }
+    /**
+     * Gets the statistics for the queue.
+     * For a queue that doesn't keep statistics, only the current depth is
+     * filled in.
+     * @return The statistics for the queue.
+     */
+    virtual queue_stats stats() const {
+        queue_stats st;
+        st.depth = size();
+        return st;
+    }
+    /**
+     * Put an item into the queue.
+     * @param val The value to add to the queue.
+     * @throw queue_closed if the queue is closed.
+     */
+    virtual void put(value_type val) = 0;
+    /**
+     * Put a control event into the queue.
+     * The client uses this for the connected and disconnected events. By
+     * default these are queued in order with the messages, but a queue can
+     * choose to hand them out ahead of any pending messages. Either way,
+     * they should not be dropped or blocked by a full queue.
+     * @param val The control event to add to the queue.
+     * @throw queue_closed if the queue is closed.
+     */
+    virtual void put_control(value_type val) { put(std::move(val)); }
+    /**
+     * Retrieve a value from the queue, blocking until one is available.
+     * @return The value removed from the queue
+     * @throw queue_closed if the queue is closed and empty.
+     */
+    virtual value_type get() = 0;
+    /**
+     * Attempts to remove a value from the queue without blocking.
+     * @param val Pointer to a variable to receive the value.
+     * @return @em true if a value was removed from the queue, @em false if
+     *  	   the queue is empty.
+     */
+    virtual bool try_get(value_type* val) = 0;
+    /**
+     * Attempt to remove an item from the queue for a bounded amount of time.
+     * @param val Pointer to a variable to receive the value.
+     * @param relTime The amount of time to wait until timing out.
+     * @return @em true if the value was removed the queue, @em false if a
+     *  	   timeout occurred.
+     */
+    virtual bool try_get_for(value_type* val, std::chrono::nanoseconds relTime) = 0;
+    /**
+     * Attempt to remove an item from the queue for a bounded amount of time.
+     * @param val Pointer to a variable to receive the value.
+     * @param relTime The amount of time to wait until timing out.
+     * @return @em true if the value was removed the queue, @em false if a
+     *  	   timeout occurred.
+     */
+    template <typename Rep, class Period>
+    bool try_get_for(value_type* val, const std::chrono::duration<Rep, Period>& relTime) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(relTime);
+        return try_get_for(val, ns);
+    }
+    /**
+     * Attempt to remove an item from the queue until an absolute time.
+     * @param val Pointer to a variable to receive the value.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return @em true if the value was removed from the queue, @em false
+     *  	   if a timeout occurred.
+     */
+    template <class Clock, class Duration>
+    bool try_get_until(
+        value_type* val, const std::chrono::time_point<Clock, Duration>& absTime
+    ) {
+        return try_get_for(val, absTime - Clock::now());
+    }
+    /**
+     * Retrieve a batch of values from the queue, blocking until at least
+     * one is available.
+     * @param vec The vector to receive the values. They are appended to
+     *  		  the back.
+     * @param n The maximum number of values to retrieve.
+     * @return The number of values retrieved. This is only zero if the
+     *  	   queue is closed and empty, or if @em n is zero.
+     */
+    virtual size_type get_n(std::vector<value_type>& vec, size_type n) = 0;
+    /**
+     * Attempts to remove a batch of values from the queue without
+     * blocking.
+     * @param vec The vector to receive the values.
+     * @param n The maximum number of values to retrieve.
+     * @return The number of values retrieved, which is zero if the queue
+     *  	   is empty.
+     */
+    virtual size_type try_get_n(std::vector<value_type>& vec, size_type n) = 0;
+    /**
+     * Attempt to remove a batch of values from the queue, waiting a
+     * bounded amount of time for the first one to arrive.
+     * @param vec The vector to receive the values.
+     * @param n The maximum number of values to retrieve.
+     * @param relTime The amount of time to wait until timing out.
+     * @return The number of values retrieved, which is zero on timeout.
+     */
+    virtual size_type try_get_n_for(
+        std::vector<value_type>& vec, size_type n, std::chrono::nanoseconds relTime
+    ) = 0;
+    /**
+     * Attempt to remove a batch of values from the queue, waiting a
+     * bounded amount of time for the first one to arrive.
+     * @param vec The vector to receive the values.
+     * @param n The maximum number of values to retrieve.
+     * @param relTime The amount of time to wait until timing out.
+     * @return The number of values retrieved, which is zero on timeout.
+     */
+    template <typename Rep, class Period>
+    size_type try_get_n_for(
+        std::vector<value_type>& vec, size_type n,
+        const std::chrono::duration<Rep, Period>& relTime
+    ) {
+        return try_get_n_for(
+            vec, n, std::chrono::duration_cast<std::chrono::nanoseconds>(relTime)
+        );
+    }
+    /**
+     * Attempt to remove a batch of values from the queue, waiting until
+     * an absolute time for the first one to arrive.
+     * @param vec The vector to receive the values.
+     * @param n The maximum number of values to retrieve.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return The number of values retrieved, which is zero on timeout.
+     */
+    template <class Clock, class Duration>
+    size_type try_get_n_until(
+        std::vector<value_type>& vec, size_type n,
+        const std::chrono::time_point<Clock, Duration>& absTime
+    ) {
+        return try_get_n_for(vec, n, absTime - Clock::now());
+    }
+};
+
+/** Smart/unique pointer to a consumer queue */
+using consumer_queue_ptr = std::unique_ptr<iconsumer_queue>;
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Adapter to use one of the library's queues as a client consumer queue.
+ *
+ * This wraps any queue with the same API as @ref thread_queue, holding
+ * @ref event items, such as:
+ *
+ * @code
+ * cli.start_consuming(consumer_queue<ring_queue<event>>::create(4096));
+ * @endcode
+ *
+ * The control events are put into the underlying queue past its capacity,
+ * if it allows that, so that a full queue never drops or blocks them.
+ *
+ * @tparam Queue The type of the underlying queue.
+ */
+template <class Queue = thread_queue<event>>
+class consumer_queue : public iconsumer_queue
+{
+    /** The underlying queue */
+    Queue que_;
+
+    /** Gets the dropped count from a queue that keeps one */
+    template <class Q>
+    static auto dropped_count(const Q& que, int) -> decltype(size_type(que.dropped())) {
+        return size_type(que.dropped());
+    }
+    /** Queues that don't keep a dropped count have never dropped anything */
+    template <class Q>
+    static size_type dropped_count(const Q&, long) {
+        return 0;
+    }
+    /** Gets the size in bytes from a queue that keeps it */
+    template <class Q>
+    static auto size_bytes_of(const Q& que, int) -> decltype(std::size_t(que.size_bytes())) {
+        return std::size_t(que.size_bytes());
+    }
+    /** Queues that don't keep their size in bytes */
+    template <class Q>
+    static std::size_t size_bytes_of(const Q&, long) {
+        return 0;
+    }
+    /** Turns on statistics for a queue that keeps them */
+    template <class Q>
+    static auto enable_stats_of(Q& que, bool on, int) -> decltype(que.enable_stats(on)) {
+        que.enable_stats(on);
+    }
+    /** Queues that don't keep statistics */
+    template <class Q>
+    static void enable_stats_of(Q&, bool, long) {}
+    /** Gets the statistics from a queue that keeps them */
+    template <class Q>
+    static auto stats_of(const Q& que, int) -> decltype(queue_stats(que.stats())) {
+        return que.stats();
+    }
+    /** Queues that don't keep statistics only know their depth */
+    template <class Q>
+    static queue_stats stats_of(const Q& que, long) {
+        queue_stats st;
+        st.depth = std::size_t(que.size());
+        return st;
+    }
+    /** Gets the notification descriptor from a queue that has one */
+    template <class Q>
+    static auto notify_fd_of(Q& que, int) -> decltype(int(que.notify_fd())) {
+        return int(que.notify_fd());
+    }
+    /** Queues without a notification descriptor */
+    template <class Q>
+    static int notify_fd_of(Q&, long) {
+        return -1;
+    }
+    /** Puts a control event past the capacity of a queue that allows it */
+    template <class Q>
+    static auto force_put_of(Q& que, value_type&& val, int)
+        -> decltype(que.force_put(std::move(val))) {
+        que.force_put(std::move(val));
+    }
+    /** Queues that can't exceed their capacity take control events normally */
+    template <class Q>
+    static void force_put_of(Q& que, value_type&& val, long) {
+        que.put(std::move(val));
+    }
+
+public:
+    /** The type of the underlying queue */
+    using queue_type = Queue;
+
+    /**
+     * Creates a consumer queue, passing the arguments to the constructor
+     * of the underlying queue.
+     */
+    template <typename... Args>
+    explicit consumer_queue(Args&&... args) : que_(std::forward<Args>(args)...) {}
+    /**
+     * Creates a consumer queue, passing the arguments to the constructor
+     * of the underlying queue.
+     * @return A pointer to the new queue, suitable to pass to the client's
+     *  	   `start_consuming()`.
+     */
+    template <typename... Args>
+    static consumer_queue_ptr create(Args&&... args) {
+        return std::make_unique<consumer_queue>(std::forward<Args>(args)...);
+    }
+    /**
+     * Gets a reference to the underlying queue.
+     * @return A reference to the underlying queue.
+     */
+    queue_type& queue() { return que_; }
+    /**
+     * Gets a const reference to the underlying queue.
+     * @return A const reference to the underlying queue.
+     */
+    const queue_type& queue() const { return que_; }
+
+    bool empty() const override { return que_.empty(); }
+    size_type capacity() const override { return size_type(que_.capacity()); }
+    size_type size() const override { return size_type(que_.size()); }
+    std::size_t size_bytes() const override { return size_bytes_of(que_, 0); }
+    void close() override { que_.close(); }
+    bool closed() const override { return que_.closed(); }
+    bool done() const override { return que_.done(); }
+    void clear() override { que_.clear(); }
+    size_type dropped() const override { return dropped_count(que_, 0); }
+    int notify_fd() override { return notify_fd_of(que_, 0); }
+    void enable_stats(bool on = true) override { enable_stats_of(que_, on, 0); }
+    queue_stats stats() const override { return stats_of(que_, 0); }
+    void put(value_type val) override { que_.put(std::move(val)); }
+    void put_control(value_type val) override { force_put_of(que_, std::move(val), 0); }
+    value_type get() override { return que_.get(); }
+    bool try_get(value_type* val) override { return que_.try_get(val); }
+
+    using iconsumer_queue::try_get_for;
+    bool try_get_for(value_type* val, std::chrono::nanoseconds relTime) override {
+        return que_.try_get_for(val, relTime);
+    }
+    size_type get_n(std::vector<value_type>& vec, size_type n) override {
+        return size_type(que_.get_n(vec, n));
+    }
+    size_type try_get_n(std::vector<value_type>& vec, size_type n) override {
+        return size_type(que_.try_get_n(vec, n));
+    }
+
+    using iconsumer_queue::try_get_n_for;
+    size_type try_get_n_for(
+        std::vector<value_type>& vec, size_type n, std::chrono::nanoseconds relTime
+    ) override {
+        return size_type(que_.try_get_n_for(vec, n, relTime));
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Adapter to use a two-lane queue as a client consumer queue, in which the
+ * control events bypass any backlog of messages.
+ *
+ * The connected and disconnected events are placed into the priority lane
+ * of the queue, so that they are handed to the application ahead of any
+ * messages that are still waiting in the queue. Events in each lane are
+ * kept in order. The underlying queue must support `put_priority()`, like
+ * @ref thread_queue.
+ *
+ * @code
+ * cli.start_consuming(priority_consumer_queue<>::create());
+ * @endcode
+ *
+ * Note that with this queue, a disconnect is reported before any messages
+ * that arrived before it, and those messages can still be read afterward.
+ *
+ * @tparam Queue The type of the underlying queue.
+ */
+template <class Queue = thread_queue<event>>
+class priority_consumer_queue : public consumer_queue<Queue>
+{
+    using base = consumer_queue<Queue>;
+
+public:
+    using typename base::value_type;
+
+    /**
+     * Creates a consumer queue, passing the arguments to the constructor
+     * of the underlying queue.
+     */
+    template <typename... Args>
+    explicit priority_consumer_queue(Args&&... args) : base(std::forward<Args>(args)...) {}
+    /**
+     * Creates a consumer queue, passing the arguments to the constructor
+     * of the underlying queue.
+     * @return A pointer to the new queue, suitable to pass to the client's
+     *  	   `start_consuming()`.
+     */
+    template <typename... Args>
+    static consumer_queue_ptr create(Args&&... args) {
+        return std::make_unique<priority_consumer_queue>(std::forward<Args>(args)...);
+    }
+
+    void put_control(value_type val) override { base::queue().put_priority(std::move(val)); }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_consumer_queue_h
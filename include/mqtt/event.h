@@ -251,6 +251,16 @@ public:
     get_message_if() noexcept {
         return std::get_if<const_message_ptr>(&evt_);
     }
+    /**
+     * Gets a const pointer to the message in the event, iff this is a
+     * message event.
+     * @return A pointer to a message pointer, if this is a message event.
+     *         Returns nulltr if this is not a message event.
+     */
+    constexpr std::add_pointer_t<const const_message_ptr>
+    get_message_if() const noexcept {
+        return std::get_if<const_message_ptr>(&evt_);
+    }
     /**
      * Gets a pointer the underlying information for a disconnected event,
      * iff this is a 'disconnected' event.
@@ -0,0 +1,694 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file flat_topic_matcher.h
+/// Declaration of MQTT flat_topic_matcher class
+/// @date 16-Oct-2026
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_flat_topic_matcher_h
+#define __mqtt_flat_topic_matcher_h
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mqtt/topic.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A collection of MQTT topic filters mapped to arbitrary values, using a
+ * compact, flat memory layout.
+ *
+ * This has the same API as @ref topic_matcher, and gives the same results,
+ * except that it doesn't accept shared subscription filters,
+ * "$share/{group}/{filter}". It is laid out to use less memory and to be
+ * more cache-friendly when there are a large number of filters:
+ *
+ * @li The nodes of the trie are kept in a single array (arena), and refer
+ *     to each other by 32-bit index rather than by pointer.
+ * @li The fields of the filters are interned. Each distinct field string
+ *     is stored once, and the trie refers to it by a 32-bit integer id.
+ * @li The children of a node are kept in a small vector of (field id, node
+ *     index) pairs, sorted by id, and searched with a binary search. The
+ *     '+' and '#' wildcard children are kept directly in the node.
+ * @li The values are kept in a separate arena, so the nodes stay small.
+ *
+ * Matching a topic splits it into fields without allocating, and looks up
+ * each field once in the table of interned strings. A field that was never
+ * used in any filter can only match wildcards.
+ * @par
+ * The basic `iterator` visits all the items in the collection, in no
+ * particular order. Removing an item leaves its node in the trie, like with
+ * @ref topic_matcher, but a call to @ref prune() rebuilds the collection,
+ * compacting the arrays and discarding any unused fields.
+ */
+template <typename T>
+class flat_topic_matcher
+{
+public:
+    using key_type = string;
+    using mapped_type = T;
+    using value_type = std::pair<key_type, mapped_type>;
+    using reference = value_type;
+    using const_reference = const value_type&;
+
+    using value_ptr = std::unique_ptr<value_type>;
+    using mapped_ptr = std::unique_ptr<mapped_type>;
+
+private:
+    /** Index type for the nodes, values, and fields */
+    using index_type = uint32_t;
+
+    /** Index used for "none" */
+    static constexpr index_type NONE = index_type(-1);
+
+    /** A link from a node to a child for a specific field */
+    struct edge
+    {
+        /** The interned id of the field */
+        index_type field;
+        /** The index of the child node */
+        index_type child;
+    };
+
+    /** A node in the trie */
+    struct node
+    {
+        /** The index of the value at this node, if any */
+        index_type value{NONE};
+        /** The child node for a '+' wildcard, if any */
+        index_type plus{NONE};
+        /** The child node for a '#' wildcard, if any */
+        index_type hash{NONE};
+        /** The child nodes for the other fields, sorted by field id */
+        std::vector<edge> children;
+
+        /** Finds the child for the field, or NONE if there isn't one */
+        index_type find(index_type field) const {
+            auto it = std::lower_bound(
+                children.begin(), children.end(), field,
+                [](const edge& e, index_type id) { return e.field < id; }
+            );
+            return (it != children.end() && it->field == field) ? it->child : NONE;
+        }
+    };
+
+    /** The nodes of the trie. The root is at index zero. */
+    std::vector<node> nodes_;
+    /** The values. Removed values leave an empty slot. */
+    std::deque<std::optional<value_type>> values_;
+    /** The indexes of the empty value slots */
+    std::vector<index_type> freeValues_;
+    /** The number of values in the collection */
+    size_t count_{0};
+    /** The interned field strings. A deque keeps their addresses stable. */
+    std::deque<string> fields_;
+    /** Map of the field strings to their ids */
+    std::unordered_map<std::string_view, index_type> fieldIds_;
+
+    /** Gets the id of a field, or NONE if it was never interned. */
+    index_type field_id(std::string_view field) const {
+        auto it = fieldIds_.find(field);
+        return (it != fieldIds_.end()) ? it->second : NONE;
+    }
+    /** Gets the id of a field, interning it if necessary */
+    index_type intern(std::string_view field) {
+        auto it = fieldIds_.find(field);
+        if (it != fieldIds_.end())
+            return it->second;
+
+        auto id = index_type(fields_.size());
+        fields_.emplace_back(field);
+        fieldIds_.emplace(std::string_view{fields_.back()}, id);
+        return id;
+    }
+    /** Creates a new, empty node, returning its index */
+    index_type new_node() {
+        nodes_.emplace_back();
+        return index_type(nodes_.size() - 1);
+    }
+    /**
+     * Splits off the next field of a topic or filter.
+     * @param s The remaining part of the topic. On return this is what
+     *  		follows the next separator.
+     * @param more Set @em true if there are more fields after this one.
+     * @return The next field.
+     */
+    static std::string_view next_field(std::string_view& s, bool& more) {
+        auto pos = s.find('/');
+        auto field = s.substr(0, pos);
+        more = (pos != std::string_view::npos);
+        s = more ? s.substr(pos + 1) : std::string_view{};
+        return field;
+    }
+    /** Finds the node for the filter, or NONE if it's not in the trie. */
+    index_type find_node(std::string_view filter) const {
+        index_type nd = 0;
+        bool more = true;
+
+        while (more && nd != NONE) {
+            auto field = next_field(filter, more);
+            if (field == "+")
+                nd = nodes_[nd].plus;
+            else if (field == "#")
+                nd = nodes_[nd].hash;
+            else {
+                auto id = field_id(field);
+                nd = (id == NONE) ? NONE : nodes_[nd].find(id);
+            }
+        }
+        return nd;
+    }
+    /** Gets a pointer to the value at the specified slot */
+    value_type* value_at(index_type i) { return (i == NONE) ? nullptr : &*values_[i]; }
+
+public:
+    /** Generic iterator over all items in the collection. */
+    class iterator
+    {
+        /** The collection */
+        flat_topic_matcher* tm_;
+        /** The index of the current value slot */
+        size_t idx_;
+
+        /** Skips forward to the next slot with a value */
+        void skip() {
+            while (idx_ < tm_->values_.size() && !tm_->values_[idx_]) ++idx_;
+        }
+
+        friend class flat_topic_matcher;
+
+        iterator(flat_topic_matcher* tm, size_t idx) : tm_{tm}, idx_{idx} {}
+
+    public:
+        /**
+         * Gets a reference to the current value.
+         * @return A reference to the current value.
+         */
+        reference operator*() noexcept { return *tm_->values_[idx_]; }
+        /**
+         * Gets a const reference to the current value.
+         * @return A const reference to the current value.
+         */
+        const_reference operator*() const noexcept { return *tm_->values_[idx_]; }
+        /**
+         * Get a pointer to the current value.
+         * @return A pointer to the current value.
+         */
+        value_type* operator->() noexcept { return &*tm_->values_[idx_]; }
+        /**
+         * Get a const pointer to the current value.
+         * @return A const pointer to the current value.
+         */
+        const value_type* operator->() const noexcept { return &*tm_->values_[idx_]; }
+        /**
+         * Postfix increment operator.
+         * @return An iterator pointing to the previous item.
+         */
+        iterator operator++(int) noexcept {
+            auto tmp = *this;
+            ++idx_;
+            skip();
+            return tmp;
+        }
+        /**
+         * Prefix increment operator.
+         * @return An iterator pointing to the next item.
+         */
+        iterator& operator++() noexcept {
+            ++idx_;
+            skip();
+            return *this;
+        }
+        /**
+         * Compares two iterators to see if they don't refer to the same
+         * item.
+         * @param other The other iterator to compare against this one.
+         * @return @em true if they don't match, @em false if they do
+         */
+        bool operator!=(const iterator& other) const noexcept { return idx_ != other.idx_; }
+    };
+
+    /** A const iterator over all items in the collection. */
+    class const_iterator : public iterator
+    {
+        using base = iterator;
+
+        friend class flat_topic_matcher;
+        const_iterator(iterator it) : base(it) {}
+
+    public:
+        /**
+         * Gets a const reference to the current value.
+         * @return A const reference to the current value.
+         */
+        const_reference operator*() const noexcept { return base::operator*(); }
+        /**
+         * Get a const pointer to the current value.
+         * @return A const pointer to the current value.
+         */
+        const value_type* operator->() const noexcept { return base::operator->(); }
+    };
+
+    /**
+     * Iterator that searches the collection for topic matches.
+     */
+    class match_iterator
+    {
+        /** A node that still needs to be searched */
+        struct search_node
+        {
+            /** The index of the node */
+            index_type node;
+            /** The offset of the next field in the topic */
+            index_type pos;
+            /** Whether there are fields left to match */
+            bool more;
+            /** Whether this is the root node */
+            bool first;
+        };
+
+        /** The collection being searched */
+        flat_topic_matcher* tm_{nullptr};
+        /** The topic being matched */
+        string topic_;
+        /** The last-found value */
+        value_type* pval_{nullptr};
+        /** The nodes still to be checked, used as a stack */
+        std::vector<search_node> nodes_;
+
+        /**
+         * Move the iterator to the next value, or to end(), if none left.
+         */
+        void next() {
+            pval_ = nullptr;
+
+            while (!nodes_.empty()) {
+                auto snode = nodes_.back();
+                nodes_.pop_back();
+
+                const auto& nd = tm_->nodes_[snode.node];
+
+                // At the end of the topic fields, we either have a value,
+                // or move on to the next node to search.
+                if (!snode.more) {
+                    if ((pval_ = tm_->value_at(nd.value)) != nullptr)
+                        return;
+                    continue;
+                }
+
+                std::string_view rest{topic_};
+                rest.remove_prefix(snode.pos);
+
+                bool more;
+                auto field = next_field(rest, more);
+                auto pos = index_type(topic_.size() - rest.size());
+
+                // Look for an exact match
+                auto id = tm_->field_id(field);
+                if (id != NONE) {
+                    auto child = nd.find(id);
+                    if (child != NONE)
+                        nodes_.push_back({child, pos, more, false});
+                }
+
+                // Topics starting with '$' don't match wildcards in the first field
+                // MQTT v5 Spec, Section 4.7.2:
+                // https://docs.oasis-open.org/mqtt/mqtt/v5.0/os/mqtt-v5.0-os.html#_Toc3901246
+
+                if (!snode.first || field.empty() || field[0] != '$') {
+                    // Look for a single-field wildcard match
+                    if (nd.plus != NONE)
+                        nodes_.push_back({nd.plus, pos, more, false});
+
+                    // Look for a terminating match
+                    if (nd.hash != NONE) {
+                        if ((pval_ = tm_->value_at(tm_->nodes_[nd.hash].value)) != nullptr)
+                            return;
+                    }
+                }
+            }
+        }
+
+        friend class flat_topic_matcher;
+
+        match_iterator() {}
+        match_iterator(flat_topic_matcher* tm, const string& topic) : tm_{tm}, topic_{topic} {
+            nodes_.push_back({0, 0, true, true});
+            next();
+        }
+
+    public:
+        /**
+         * Gets a reference to the current value.
+         * @return A reference to the current value.
+         */
+        reference operator*() noexcept { return *pval_; }
+        /**
+         * Gets a const reference to the current value.
+         * @return A const reference to the current value.
+         */
+        const_reference operator*() const noexcept { return *pval_; }
+        /**
+         * Get a pointer to the current value.
+         * @return A pointer to the current value.
+         */
+        value_type* operator->() noexcept { return pval_; }
+        /**
+         * Get a const pointer to the current value.
+         * @return A const pointer to the current value.
+         */
+        const value_type* operator->() const noexcept { return pval_; }
+        /**
+         * Postfix increment operator.
+         * @return An iterator pointing to the previous matching item.
+         */
+        match_iterator operator++(int) noexcept {
+            auto tmp = *this;
+            this->next();
+            return tmp;
+        }
+        /**
+         * Prefix increment operator.
+         * @return An iterator pointing to the next matching item.
+         */
+        match_iterator& operator++() noexcept {
+            this->next();
+            return *this;
+        }
+        /**
+         * Compares two iterators to see if they don't refer to the same
+         * node.
+         *
+         * @param other The other iterator to compare against this one.
+         * @return @em true if they don't match, @em false if they do
+         */
+        bool operator!=(const match_iterator& other) const noexcept {
+            return pval_ != other.pval_;
+        }
+    };
+
+    /**
+     * A const match iterator.
+     */
+    class const_match_iterator : public match_iterator
+    {
+        using base = match_iterator;
+
+        friend class flat_topic_matcher;
+        const_match_iterator(match_iterator it) : base(std::move(it)) {}
+
+    public:
+        /**
+         * Gets a const reference to the current value.
+         * @return A const reference to the current value.
+         */
+        const_reference operator*() const noexcept { return base::operator*(); }
+        /**
+         * Get a const pointer to the current value.
+         * @return A const pointer to the current value.
+         */
+        const value_type* operator->() const noexcept { return base::operator->(); }
+    };
+
+    /**
+     * Creates  new, empty collection.
+     */
+    flat_topic_matcher() { new_node(); }
+    /**
+     * Creates a new collection with a list of key/value pairs.
+     * @param lst The list of key/value pairs to populate the collection.
+     */
+    flat_topic_matcher(std::initializer_list<value_type> lst) : flat_topic_matcher() {
+        for (const auto& v : lst) {
+            insert(v);
+        }
+    }
+    /**
+     * The collection can't be copied, since the table of fields refers to
+     * its own strings.
+     */
+    flat_topic_matcher(const flat_topic_matcher&) = delete;
+    /**
+     * Move constructor.
+     * The interned strings stay where they are, in the moved blocks of the
+     * deque, so the table of fields is still valid.
+     */
+    flat_topic_matcher(flat_topic_matcher&&) = default;
+    /**
+     * The collection can't be copied.
+     */
+    flat_topic_matcher& operator=(const flat_topic_matcher&) = delete;
+    /**
+     * Move assignment.
+     */
+    flat_topic_matcher& operator=(flat_topic_matcher&&) = default;
+    /**
+     * Determines if the collection is empty.
+     * @return @em true if the collection is empty, @em false if it contains
+     *         any filters.
+     */
+    bool empty() const { return count_ == 0; }
+    /**
+     * Gets the number of filters in the collection.
+     * @return The number of filters in the collection.
+     */
+    size_t size() const { return count_; }
+    /**
+     * Gets the number of nodes in the trie.
+     * @return The number of nodes in the trie.
+     */
+    size_t node_count() const { return nodes_.size(); }
+    /**
+     * Gets the number of distinct fields interned by the collection.
+     * @return The number of distinct fields in the collection.
+     */
+    size_t field_count() const { return fields_.size(); }
+    /**
+     * Inserts a new key/value pair into the collection.
+     * If the filter is already in the collection, its value is replaced.
+     * @param val The value to place in the collection.
+     * @throw std::invalid_argument if the filter is for a shared
+     *  	  subscription.
+     */
+    void insert(value_type&& val) {
+        if (topic_filter::is_shared(val.first))
+            throw std::invalid_argument("Shared subscription filters are not supported");
+
+        index_type nd = 0;
+        std::string_view filter{val.first};
+        bool more = true;
+
+        while (more) {
+            auto field = next_field(filter, more);
+            index_type child;
+
+            // Note that new_node() can move the nodes, so we index them
+            // each time, rather than keeping a reference.
+            if (field == "+") {
+                if ((child = nodes_[nd].plus) == NONE) {
+                    child = new_node();
+                    nodes_[nd].plus = child;
+                }
+            }
+            else if (field == "#") {
+                if ((child = nodes_[nd].hash) == NONE) {
+                    child = new_node();
+                    nodes_[nd].hash = child;
+                }
+            }
+            else {
+                auto id = intern(field);
+                if ((child = nodes_[nd].find(id)) == NONE) {
+                    child = new_node();
+                    auto& children = nodes_[nd].children;
+                    auto it = std::lower_bound(
+                        children.begin(), children.end(), id,
+                        [](const edge& e, index_type id) { return e.field < id; }
+                    );
+                    children.insert(it, edge{id, child});
+                }
+            }
+            nd = child;
+        }
+
+        auto& slot = nodes_[nd].value;
+        if (slot != NONE) {
+            values_[slot] = std::move(val);
+        }
+        else {
+            if (!freeValues_.empty()) {
+                slot = freeValues_.back();
+                freeValues_.pop_back();
+                values_[slot] = std::move(val);
+            }
+            else {
+                slot = index_type(values_.size());
+                values_.emplace_back(std::move(val));
+            }
+            ++count_;
+        }
+    }
+    /**
+     * Inserts a new value into the collection.
+     * @param val The value to place in the collection.
+     * @throw std::invalid_argument if the filter is for a shared
+     *  	  subscription.
+     */
+    void insert(const value_type& val) {
+        value_type v{val};
+        this->insert(std::move(v));
+    }
+    /**
+     * Removes an entry from the collection.
+     *
+     * This removes the value from the internal node, but leaves the node in
+     * the collection, even if it is empty.
+     * @param filter The topic filter to remove.
+     * @return A unique pointer to the value, if any.
+     */
+    mapped_ptr remove(const key_type& filter) {
+        auto nd = find_node(filter);
+        if (nd == NONE || nodes_[nd].value == NONE)
+            return mapped_ptr{};
+
+        auto slot = nodes_[nd].value;
+        auto val = std::make_unique<mapped_type>(std::move(values_[slot]->second));
+
+        values_[slot].reset();
+        freeValues_.push_back(slot);
+        nodes_[nd].value = NONE;
+        --count_;
+        return val;
+    }
+    /**
+     * Removes the empty nodes in the collection.
+     *
+     * This rebuilds the collection from the remaining values, which
+     * compacts the nodes and values, and discards any fields that are no
+     * longer used.
+     */
+    void prune() {
+        flat_topic_matcher tm;
+        for (auto& val : values_) {
+            if (val)
+                tm.insert(std::move(*val));
+        }
+        *this = std::move(tm);
+    }
+    /**
+     * Gets an iterator to the full collection of filters.
+     * @return An iterator to the full collection of filters.
+     */
+    iterator begin() {
+        iterator it{this, 0};
+        it.skip();
+        return it;
+    }
+    /**
+     * Gets an iterator to the end of the collection of filters.
+     * @return An iterator to the end of collection of filters.
+     */
+    iterator end() { return iterator{this, values_.size()}; }
+    /**
+     * Gets an iterator to the end of the collection of filters.
+     * @return An iterator to the end of collection of filters.
+     */
+    const_iterator end() const noexcept {
+        return const_cast<flat_topic_matcher*>(this)->end();
+    }
+    /**
+     * Gets a const iterator to the full collection of filters.
+     * @return A const iterator to the full collection of filters.
+     */
+    const_iterator cbegin() const { return const_cast<flat_topic_matcher*>(this)->begin(); }
+    /**
+     * Gets a const iterator to the end of the collection of filters.
+     * @return A const iterator to the end of collection of filters.
+     */
+    const_iterator cend() const noexcept { return end(); }
+    /**
+     * Gets a pointer to the value at the requested key.
+     * @param filter The topic filter entry to find.
+     * @return An iterator to the value if found, @em end() if not found.
+     */
+    iterator find(const key_type& filter) {
+        auto nd = find_node(filter);
+        if (nd == NONE || nodes_[nd].value == NONE)
+            return end();
+        return iterator{this, nodes_[nd].value};
+    }
+    /**
+     * Gets a const pointer to the value at the requested key.
+     * @param filter The topic filter entry to find.
+     * @return A const iterator to the value if found, @em end() if not
+     *  	   found.
+     */
+    const_iterator find(const key_type& filter) const {
+        return const_cast<flat_topic_matcher*>(this)->find(filter);
+    }
+    /**
+     * Gets an match_iterator that can find the matches to the topic.
+     * @param topic The topic to search for matches.
+     * @return An iterator that can find the matches to the topic.
+     */
+    match_iterator matches(const string& topic) { return match_iterator(this, topic); }
+    /**
+     * Gets a const iterator that can find the matches to the topic.
+     * @param topic The topic to search for matches.
+     * @return A const iterator that can find the matches to the topic.
+     */
+    const_match_iterator matches(const string& topic) const {
+        return match_iterator(const_cast<flat_topic_matcher*>(this), topic);
+    }
+    /**
+     * Gets an iterator for the end of the collection.
+     * @return An empty/null iterator indicating the end of the collection.
+     */
+    const_match_iterator matches_end() const noexcept { return match_iterator{}; }
+    /**
+     * Gets an iterator for the end of the collection.
+     * @return An empty/null iterator indicating the end of the collection.
+     */
+    const_match_iterator matches_cend() const noexcept { return match_iterator{}; }
+    /**
+     * Determines if there are any matches for the specified topic.
+     * @param topic The topic to search for matches.
+     * @return Whether there are any matches for the topic in the
+     *         collection.
+     */
+    bool has_match(const string& topic) { return matches(topic) != matches_cend(); }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_flat_topic_matcher_h
@@ -0,0 +1,258 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file message_router.h
+/// Declaration of MQTT message_router class, which sends incoming messages
+/// to the handlers registered for the topic filters that they match.
+/// @date 16-Oct-2026
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_message_router_h
+#define __mqtt_message_router_h
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "mqtt/concurrent_topic_matcher.h"
+#include "mqtt/message.h"
+#include "mqtt/rcu_ptr.h"
+#include "mqtt/sharded_dispatcher.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Where the handler for a route is run.
+ */
+enum class route_mode {
+    /** The handler is called directly by the thread that routes the message */
+    direct,
+    /** The handler is called from the router's pool of worker threads */
+    worker
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Sends incoming messages to the handlers registered for the topic filters
+ * that they match.
+ *
+ * Each route maps a topic filter to a handler. When a message is routed,
+ * the handler of every route with a filter that matches the message topic
+ * is called. A route can have its handler run directly, by the thread that
+ * routes the message, or on a pool of worker threads, which hash each
+ * message to a worker by its topic, so the messages for a topic are
+ * handled in order.
+ * @par
+ * The routes are kept in a @ref concurrent_topic_matcher, so they can be
+ * added and removed by any thread while messages are being routed. Routing
+ * a message doesn't take any lock of the router, and doesn't allocate any
+ * memory unless it matches worker routes. A message for the workers is
+ * queued along with the handlers of the worker routes that it matched
+ * when it was routed, so changes to the routes don't affect the messages
+ * that are already queued.
+ * @par
+ * A route can also be given an MQTT v5 subscription identifier, to be sent
+ * to the server when subscribing to its filter. The server then tags each
+ * message with the identifiers of the subscriptions that it matched, and
+ * while all the routes have identifiers, the router finds the handlers by
+ * looking up the identifiers in a table, without matching the topic at
+ * all. Like the routes, the table is read without any lock. Messages
+ * without identifiers, such as from MQTT v3 connections, are routed by
+ * matching their topics.
+ * @par
+ * The worker threads are started by @ref start_workers(), or when the first
+ * worker route is added, and run until the router is destroyed.
+ */
+class message_router
+{
+public:
+    /** Handler type for the messages */
+    using handler_type = std::function<void(const_message_ptr)>;
+
+    /** The largest subscription identifier allowed by MQTT v5 */
+    static constexpr uint32_t MAX_SUBSCRIPTION_ID = 268435455;
+
+private:
+    /** A route: the handler for a filter, and where it runs */
+    struct route_entry
+    {
+        /** The message handler. Shared with the queued worker messages. */
+        std::shared_ptr<const handler_type> handler;
+        /** Where the handler is run */
+        route_mode mode;
+        /** The subscription identifier, or zero if none */
+        uint32_t subId;
+    };
+    /**
+     * The routes with subscription identifiers, sorted by identifier.
+     * The identifiers are assigned in increasing order, so a new one always
+     * goes at the end.
+     */
+    using id_table = std::vector<std::pair<uint32_t, route_entry>>;
+
+    /** The routes, keyed by topic filter */
+    concurrent_topic_matcher<route_entry> routes_;
+    /** The routes by subscription identifier */
+    rcu_ptr<id_table> ids_;
+    /** The number of routes */
+    std::atomic<std::size_t> nRoutes_{0};
+    /** The number of routes without a subscription identifier */
+    std::atomic<std::size_t> nPlain_{0};
+    /** The next unused subscription identifier. These are never reused. */
+    uint32_t nextId_{1};
+    /** The workers for the worker routes, once started */
+    sharded_dispatcher_ptr workers_;
+    /** The workers, for the routing threads. Set once when started. */
+    std::atomic<sharded_dispatcher*> pworkers_{nullptr};
+    /** Lock to serialize changes to the routes and workers */
+    std::mutex lock_;
+
+    /** Adds or replaces a route, with or without a subscription id */
+    uint32_t add(const string& filter, handler_type handler, route_mode mode, bool withId);
+    /** Gets an unused subscription id. Must be called with the lock held. */
+    uint32_t next_id();
+    /** Publishes a changed copy of the id table. Must hold the lock. */
+    template <typename Fn>
+    void update_ids(Fn fn);
+    /** Calls a function for each route of the message */
+    template <typename Fn>
+    std::size_t for_each_route(const message& msg, Fn fn) const;
+
+public:
+    /**
+     * Creates a router with no routes.
+     */
+    message_router();
+    /**
+     * Stops any workers and destroys the router.
+     */
+    ~message_router();
+
+    message_router(const message_router&) = delete;
+    message_router& operator=(const message_router&) = delete;
+
+    /**
+     * Determines if there are any routes.
+     * @return @em true if there are no routes, @em false otherwise.
+     */
+    bool empty() const { return nRoutes_.load(std::memory_order_acquire) == 0; }
+    /**
+     * Gets the number of routes.
+     * @return The number of routes.
+     */
+    std::size_t size() const { return nRoutes_.load(std::memory_order_acquire); }
+    /**
+     * Determines if the worker threads are running.
+     * @return @em true if the workers were started, @em false otherwise.
+     */
+    bool has_workers() const { return pworkers_.load(std::memory_order_acquire) != nullptr; }
+    /**
+     * Starts the worker threads for the worker routes.
+     * @param nWorkers The number of worker threads. The minimum is one.
+     * @param opts Options for the workers. The key function is ignored,
+     *  		   since the messages are always sharded by topic.
+     * @return @em true if the workers were started, @em false if they were
+     *  	   already running.
+     */
+    bool start_workers(
+        std::size_t nWorkers, const dispatch_options& opts = dispatch_options{}
+    );
+    /**
+     * Adds a route, or replaces the route for a filter that already has
+     * one.
+     * If this is a worker route, and the workers were not yet started, a
+     * worker is started for each hardware thread. If the filter had a
+     * subscription identifier, it is dropped, and not reused.
+     * @param filter The topic filter.
+     * @param handler The handler for messages that match the filter.
+     * @param mode Where the handler is run.
+     * @throw std::invalid_argument if the handler is empty.
+     */
+    void add_route(
+        const string& filter, handler_type handler, route_mode mode = route_mode::direct
+    ) {
+        add(filter, std::move(handler), mode, false);
+    }
+    /**
+     * Adds a route with an MQTT v5 subscription identifier, or replaces
+     * the route for a filter that already has one.
+     * A new identifier is assigned to the filter, unless it already had
+     * one. This should then be sent to the server in the properties of the
+     * subscribe request for the filter. Identifiers are never reused, even
+     * after their routes are removed, since the server can still send
+     * messages tagged with them.
+     * @param filter The topic filter.
+     * @param handler The handler for messages that match the filter.
+     * @param mode Where the handler is run.
+     * @return The subscription identifier for the filter.
+     * @throw std::invalid_argument if the handler is empty.
+     * @throw std::out_of_range if all the identifiers were used.
+     */
+    uint32_t add_subscription_route(
+        const string& filter, handler_type handler, route_mode mode = route_mode::direct
+    ) {
+        return add(filter, std::move(handler), mode, true);
+    }
+    /**
+     * Gets the subscription identifier of the route for a filter.
+     * @param filter The topic filter.
+     * @return The subscription identifier for the filter, or zero if it
+     *  	   has no route, or its route has no identifier.
+     */
+    uint32_t subscription_id(const string& filter) const;
+    /**
+     * Removes the route for a filter.
+     * Its subscription identifier, if any, is not reused by a later route.
+     * Messages that are already queued for a worker are still sent to the
+     * handler.
+     * @param filter The topic filter.
+     * @return @em true if the route was removed, @em false if there was no
+     *  	   route for the filter.
+     */
+    bool remove_route(const string& filter);
+    /**
+     * Removes all the routes.
+     */
+    void clear();
+    /**
+     * Sends a message to the handlers of all the routes that match its
+     * topic.
+     * If all the routes have subscription identifiers, and the message
+     * carries any, the routes are found by their identifiers. Otherwise
+     * they're found by matching the topic of the message.
+     * The direct handlers are called before this returns. The message is
+     * queued once for the workers, if any worker routes match. An
+     * exception from a handler is ignored, so that it doesn't keep the
+     * message from the other routes.
+     * @param msg The message.
+     * @return The number of routes that matched the message.
+     */
+    std::size_t route(const const_message_ptr& msg);
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_message_router_h
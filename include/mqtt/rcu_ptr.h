@@ -0,0 +1,282 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file rcu_ptr.h
+/// Declaration of MQTT rcu_ptr class
+/// @date 16-Oct-2026
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_rcu_ptr_h
+#define __mqtt_rcu_ptr_h
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A shared pointer to an immutable value that is replaced, as a whole, by
+ * writers and read by many threads, in a read-copy-update (RCU) scheme.
+ *
+ * Loading or storing a `std::shared_ptr` atomically is not lock-free in the
+ * common standard libraries, which guard it with a pool of mutexes, and
+ * every load also increments and decrements the reference count shared by
+ * all the readers. So the readers contend with each other.
+ * @par
+ * To avoid that, each thread keeps its own cached reference to the latest
+ * value that it saw, along with the version of the pointer at the time.
+ * The version is incremented each time a new value is stored. A reader
+ * using @ref with_local() only has to load the version, which is never
+ * written by the readers, and compare it to the one in its cache. It only
+ * goes back to the shared pointer when the value has changed. So in the
+ * steady state, readers take no lock and write no shared memory, and
+ * reading scales with the number of threads.
+ * @par
+ * A thread's cached copy of a value is kept alive until the pointer has a
+ * new value that the thread reads, or until the pointer is destroyed, or
+ * the thread exits. The pointer keeps a registry of the threads that have
+ * a copy, so that it can release all of them when it's destroyed.
+ */
+template <typename T>
+class rcu_ptr
+{
+public:
+    /** A pointer to an immutable value */
+    using pointer_type = std::shared_ptr<const T>;
+
+private:
+    /**
+     * A thread's cached copy of the pointer.
+     * This is shared by the thread that uses it and the registry of the
+     * rcu_ptr. The cached value is only changed by its own thread while
+     * the rcu_ptr is alive. After that, the rcu_ptr or the thread,
+     * whichever goes first, releases it under the lock.
+     */
+    struct slot
+    {
+        /** Lock to release the cached value from another thread */
+        std::mutex lock;
+        /** Set when the rcu_ptr or the thread is gone */
+        std::atomic<bool> gone{false};
+        /** The number of readers using the cached value on its thread */
+        std::atomic<int> nBusy{0};
+        /** The version of the cached value */
+        uint64_t ver{0};
+        /** The cached value */
+        pointer_type ptr;
+
+        /**
+         * Marks the slot as gone, and releases the cached value unless a
+         * reader on the slot's own thread is still using it.
+         */
+        void release() {
+            pointer_type tmp;
+            {
+                std::lock_guard<std::mutex> g{lock};
+                gone.store(true, std::memory_order_release);
+                if (nBusy.load(std::memory_order_relaxed) == 0)
+                    tmp = std::move(ptr);
+            }
+        }
+    };
+
+    /** The slots of one thread, for all the pointers that it has read */
+    struct local_cache
+    {
+        /** The slots, by the ID of their rcu_ptr */
+        std::unordered_map<uint64_t, std::shared_ptr<slot>> slots;
+        /** The ID of the last pointer read on the thread */
+        uint64_t lastId{0};
+        /** The slot of the last pointer read on the thread */
+        slot* last{nullptr};
+
+        ~local_cache() {
+            for (auto& s : slots) s.second->release();
+        }
+    };
+
+    /** The current value. Only accessed atomically. */
+    pointer_type ptr_;
+    /** The version, incremented each time a new value is stored */
+    std::atomic<uint64_t> version_{0};
+    /** A unique ID, to find the value in the thread caches */
+    const uint64_t id_;
+    /** Lock for the registry of thread slots */
+    mutable std::mutex regLock_;
+    /** The slots of the threads that have a cached copy of the value */
+    mutable std::vector<std::shared_ptr<slot>> slots_;
+
+    /** Gets a unique ID for a new object */
+    static uint64_t next_id() {
+        static std::atomic<uint64_t> id{0};
+        return id.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    /** Gets the cache of the calling thread */
+    static local_cache& cache() {
+        thread_local local_cache c;
+        return c;
+    }
+    /**
+     * Creates a cache slot for the calling thread, and registers it.
+     * This is only done the first time a thread reads the pointer.
+     */
+    slot* add_slot(local_cache& c) const {
+        // Drop the slots of pointers that were destroyed
+        for (auto it = c.slots.begin(); it != c.slots.end();) {
+            if (it->second->gone.load(std::memory_order_acquire))
+                it = c.slots.erase(it);
+            else
+                ++it;
+        }
+        c.lastId = 0;
+        c.last = nullptr;
+
+        auto s = std::make_shared<slot>();
+        s->ver = version();
+        s->ptr = load();
+
+        {
+            std::lock_guard<std::mutex> g{regLock_};
+            // Drop the slots of threads that exited
+            slots_.erase(
+                std::remove_if(
+                    slots_.begin(), slots_.end(),
+                    [](const std::shared_ptr<slot>& p) {
+                        return p->gone.load(std::memory_order_acquire);
+                    }
+                ),
+                slots_.end()
+            );
+            slots_.push_back(s);
+        }
+        return c.slots.emplace(id_, std::move(s)).first->second.get();
+    }
+    /**
+     * Gets the calling thread's cache slot, with the current value.
+     * @return The slot, or null if it's in use by an outer reader and out
+     *  	   of date.
+     */
+    slot* local_slot() const {
+        auto& c = cache();
+        slot* s = c.last;
+
+        if (c.lastId != id_) {
+            auto it = c.slots.find(id_);
+            s = (it != c.slots.end()) ? it->second.get() : add_slot(c);
+            c.lastId = id_;
+            c.last = s;
+        }
+
+        auto ver = version();
+        if (s->ver != ver) {
+            // An outer reader on this thread still needs the old value
+            if (s->nBusy.load(std::memory_order_relaxed))
+                return nullptr;
+            s->ptr = load();
+            s->ver = ver;
+        }
+        return s;
+    }
+
+public:
+    /**
+     * Creates a pointer to a value.
+     * @param ptr The initial value.
+     */
+    explicit rcu_ptr(pointer_type ptr) : ptr_{std::move(ptr)}, id_{next_id()} {}
+    /**
+     * Destroys the pointer, releasing the copies of the value cached by
+     * all the threads.
+     */
+    ~rcu_ptr() {
+        std::lock_guard<std::mutex> g{regLock_};
+        for (auto& s : slots_) s->release();
+    }
+
+    rcu_ptr(const rcu_ptr&) = delete;
+    rcu_ptr& operator=(const rcu_ptr&) = delete;
+
+    /**
+     * Gets the current value from the shared pointer.
+     * This is not lock-free with most standard libraries, and touches the
+     * shared reference count. Use @ref with_local() on hot paths.
+     * @return A pointer to the current value.
+     */
+    pointer_type load() const {
+        return std::atomic_load_explicit(&ptr_, std::memory_order_acquire);
+    }
+    /**
+     * Replaces the value.
+     * Stores must be serialized by the caller.
+     * @param ptr The new value.
+     */
+    void store(pointer_type ptr) {
+        std::atomic_store_explicit(&ptr_, std::move(ptr), std::memory_order_release);
+        version_.fetch_add(1, std::memory_order_release);
+    }
+    /**
+     * Gets the version of the value.
+     * This is incremented each time a new value is stored.
+     * @return The version of the value.
+     */
+    uint64_t version() const { return version_.load(std::memory_order_acquire); }
+    /**
+     * Calls a function with the current value, using the calling thread's
+     * cached copy when it's up to date.
+     * The function can safely read the same or another pointer again, or
+     * store a new value. The reference is only valid during the call.
+     * @param fn The function, as `fn(const T&)`.
+     * @return The return value of the function.
+     */
+    template <typename Fn>
+    decltype(auto) with_local(Fn&& fn) const {
+        auto s = local_slot();
+        if (!s) {
+            auto ptr = load();
+            return std::forward<Fn>(fn)(*ptr);
+        }
+
+        // This only uses the slot, in case the function destroys the rcu_ptr
+        struct busy_guard
+        {
+            slot* s;
+            ~busy_guard() {
+                auto n = s->nBusy.load(std::memory_order_relaxed) - 1;
+                s->nBusy.store(n, std::memory_order_relaxed);
+                if (n == 0 && s->gone.load(std::memory_order_acquire))
+                    s->release();
+            }
+        } guard{s};
+
+        auto n = s->nBusy.load(std::memory_order_relaxed) + 1;
+        s->nBusy.store(n, std::memory_order_relaxed);
+        return std::forward<Fn>(fn)(*s->ptr);
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_rcu_ptr_h
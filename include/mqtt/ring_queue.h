@@ -0,0 +1,516 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file ring_queue.h
+/// Implementation of the template class 'ring_queue', a lock-free, bounded,
+/// blocking queue for passing data between threads.
+/// @date 16-Oct-2026
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_ring_queue_h
+#define __mqtt_ring_queue_h
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "mqtt/thread_queue.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A lock-free, fixed-capacity queue for inter-thread communication.
+ *
+ * This is a bounded, multi-producer, multi-consumer ring buffer with the
+ * same blocking semantics as @ref thread_queue: put() blocks while the
+ * queue is full, get() blocks while it is empty, and there are
+ * non-blocking (try_put, try_get) and bounded-time (try_put_for,
+ * try_get_for, etc) variations of each.
+ * @par
+ * Placing items into and removing items from the queue is lock-free. Each
+ * slot in the ring carries a sequence number that the producers and
+ * consumers use to claim it with a single atomic compare-and-swap, so a
+ * producer and a consumer never contend for a common lock while the queue
+ * is neither empty nor full. A mutex and condition variable are only used
+ * to park a thread that needs to block, and a thread that adds or removes
+ * an item only touches them if there is actually someone waiting.
+ * @par
+ * The capacity is fixed when the queue is created and is rounded up to
+ * the next power of two. It can not be changed later.
+ * @par
+ * Like the @ref thread_queue, the queue can be closed. After that, no new
+ * items can be placed into it, but receivers can still get any items that
+ * were added before it was closed.
+ *
+ * @tparam T The type of the items to be held in the queue. It must be
+ *  		 default constructible and move assignable.
+ */
+template <typename T>
+class ring_queue
+{
+public:
+    /** The type of items to be held in the queue. */
+    using value_type = T;
+    /** The type used to specify number of items in the container. */
+    using size_type = std::size_t;
+
+    /** The default capacity of the queue */
+    static constexpr size_type DFLT_CAPACITY = 1024;
+
+private:
+    /** A slot in the ring buffer */
+    struct cell
+    {
+        /** Sequence number that tells who owns the slot */
+        std::atomic<size_type> seq;
+        /** The item in the slot */
+        value_type val;
+    };
+
+    /** Size of a cache line, to keep the producer and consumer apart */
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    /** The ring buffer */
+    std::unique_ptr<cell[]> buf_;
+    /** Mask to convert a position into a buffer index */
+    size_type mask_;
+    /** The position of the next slot to put into */
+    alignas(CACHE_LINE_SIZE) std::atomic<size_type> putPos_{0};
+    /** The position of the next slot to get from */
+    alignas(CACHE_LINE_SIZE) std::atomic<size_type> getPos_{0};
+    /** Whether the queue is closed */
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> closed_{false};
+
+    /** Lock to park waiting threads */
+    std::mutex lock_;
+    /** Condition get signaled when item added to empty queue */
+    std::condition_variable notEmptyCond_;
+    /** Condition gets signaled then item removed from full queue */
+    std::condition_variable notFullCond_;
+    /** The number of threads blocked waiting for an item */
+    std::atomic<int> nGetWaiting_{0};
+    /** The number of threads blocked waiting for space */
+    std::atomic<int> nPutWaiting_{0};
+
+    /** Simple, scope-based lock guard */
+    using guard = std::lock_guard<std::mutex>;
+    /** General purpose guard */
+    using unique_guard = std::unique_lock<std::mutex>;
+
+    /** Gets the smallest power of two that is not less than n (min 2) */
+    static size_type ring_size(size_type n) {
+        size_type sz = 2;
+        while (sz < n) sz <<= 1;
+        return sz;
+    }
+    /** Determines if there's an empty slot ready to put into */
+    bool can_put() const {
+        auto pos = putPos_.load(std::memory_order_relaxed);
+        return buf_[pos & mask_].seq.load(std::memory_order_acquire) == pos;
+    }
+    /** Determines if there's an item ready to get */
+    bool can_get() const {
+        auto pos = getPos_.load(std::memory_order_relaxed);
+        return buf_[pos & mask_].seq.load(std::memory_order_acquire) == pos + 1;
+    }
+    /**
+     * Claims a free slot and moves the value into it.
+     * This is the lock-free core of all the put operations.
+     */
+    bool do_put(value_type& val) {
+        auto pos = putPos_.load(std::memory_order_relaxed);
+        while (true) {
+            cell& c = buf_[pos & mask_];
+            auto seq = c.seq.load(std::memory_order_acquire);
+            auto dif = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+
+            if (dif == 0) {
+                if (putPos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.val = std::move(val);
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    break;
+                }
+            }
+            else if (dif < 0)  // full
+                return false;
+            else
+                pos = putPos_.load(std::memory_order_relaxed);
+        }
+        wake(nGetWaiting_, notEmptyCond_);
+        return true;
+    }
+    /**
+     * Claims an occupied slot and moves the value out of it.
+     * This is the lock-free core of all the get operations.
+     */
+    bool do_get(value_type* val) {
+        auto pos = getPos_.load(std::memory_order_relaxed);
+        while (true) {
+            cell& c = buf_[pos & mask_];
+            auto seq = c.seq.load(std::memory_order_acquire);
+            auto dif = std::ptrdiff_t(seq) - std::ptrdiff_t(pos + 1);
+
+            if (dif == 0) {
+                if (getPos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    *val = std::move(c.val);
+                    c.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    break;
+                }
+            }
+            else if (dif < 0)  // empty
+                return false;
+            else
+                pos = getPos_.load(std::memory_order_relaxed);
+        }
+        wake(nPutWaiting_, notFullCond_);
+        return true;
+    }
+    /**
+     * Wakes a parked thread, but only if there is one.
+     * The fence pairs with the one in park() so that either the waiter
+     * sees the change to the ring, or we see the waiter.
+     */
+    void wake(std::atomic<int>& nWaiting, std::condition_variable& cond) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (nWaiting.load(std::memory_order_relaxed) > 0) {
+            guard g{lock_};
+            cond.notify_one();
+        }
+    }
+    /**
+     * Parks the calling thread until the predicate is true or the time
+     * point is reached.
+     * @return The value of the predicate on return.
+     */
+    template <class Pred, class Clock, class Duration>
+    bool park(
+        std::atomic<int>& nWaiting, std::condition_variable& cond, Pred pred,
+        const std::chrono::time_point<Clock, Duration>* absTime
+    ) {
+        unique_guard g{lock_};
+        nWaiting.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        bool ok = true;
+        if (absTime)
+            ok = cond.wait_until(g, *absTime, pred);
+        else
+            cond.wait(g, pred);
+
+        nWaiting.fetch_sub(1, std::memory_order_relaxed);
+        return ok;
+    }
+    /** Blocking put, with an optional timeout */
+    template <class Clock, class Duration>
+    bool put_until(value_type& val, const std::chrono::time_point<Clock, Duration>* absTime) {
+        while (true) {
+            if (closed_.load(std::memory_order_acquire))
+                return false;
+            if (do_put(val))
+                return true;
+
+            auto pred = [this] { return can_put() || closed_.load(); };
+            if (!park(nPutWaiting_, notFullCond_, pred, absTime))
+                return false;
+        }
+    }
+    /** Blocking get, with an optional timeout */
+    template <class Clock, class Duration>
+    bool get_until(value_type* val, const std::chrono::time_point<Clock, Duration>* absTime) {
+        while (true) {
+            if (do_get(val))
+                return true;
+            if (closed_.load(std::memory_order_acquire) && !can_get())
+                return false;
+
+            auto pred = [this] { return can_get() || closed_.load(); };
+            if (!park(nGetWaiting_, notEmptyCond_, pred, absTime))
+                return false;
+        }
+    }
+
+    /** Blocking batch get, waiting (optionally) only for the first item */
+    template <class Clock, class Duration>
+    size_type first_n(
+        std::vector<value_type>& vec, size_type n,
+        const std::chrono::time_point<Clock, Duration>* absTime
+    ) {
+        value_type val;
+        if (n == 0 || !get_until(&val, absTime))
+            return 0;
+
+        vec.push_back(std::move(val));
+        return 1 + try_get_n(vec, n - 1);
+    }
+
+    using steady_time_point = std::chrono::steady_clock::time_point;
+
+public:
+    /**
+     * Constructs a queue with the default capacity.
+     */
+    ring_queue() : ring_queue(DFLT_CAPACITY) {}
+    /**
+     * Constructs a queue with the specified capacity.
+     * @param cap The maximum number of items that can be placed in the
+     *  		  queue. This is rounded up to the next power of two.
+     */
+    explicit ring_queue(size_type cap)
+        : buf_{new cell[ring_size(cap)]}, mask_{ring_size(cap) - 1} {
+        for (size_type i = 0; i <= mask_; ++i)
+            buf_[i].seq.store(i, std::memory_order_relaxed);
+    }
+    /**
+     * Determine if the queue is empty.
+     * @return @em true if there are no elements in the queue, @em false if
+     *  	   there are any items in the queue.
+     */
+    bool empty() const { return size() == 0; }
+    /**
+     * Gets the capacity of the queue.
+     * @return The maximum number of elements before the queue is full.
+     */
+    size_type capacity() const { return mask_ + 1; }
+    /**
+     * Gets the number of items in the queue.
+     * Since other threads may be adding and removing items at the same
+     * time, this is only a snapshot of the size.
+     * @return The number of items in the queue.
+     */
+    size_type size() const {
+        auto getPos = getPos_.load(std::memory_order_acquire);
+        auto putPos = putPos_.load(std::memory_order_acquire);
+        return (putPos > getPos) ? std::min(putPos - getPos, capacity()) : 0;
+    }
+    /**
+     * Close the queue.
+     * Once closed, the queue will not accept any new items, but receievers
+     * will still be able to get any remaining items out of the queue until
+     * it is empty.
+     */
+    void close() {
+        closed_.store(true);
+        guard g{lock_};
+        notFullCond_.notify_all();
+        notEmptyCond_.notify_all();
+    }
+    /**
+     * Determines if the queue is closed.
+     * @return @em true if the queue is closed, @false otherwise.
+     */
+    bool closed() const { return closed_.load(); }
+    /**
+     * Determines if all possible operations are done on the queue.
+     * @return @true if the queue is closed and empty, @em false otherwise.
+     */
+    bool done() const { return closed() && !can_get(); }
+    /**
+     * Clear the contents of the queue.
+     * This discards all items in the queue.
+     */
+    void clear() {
+        value_type val;
+        while (do_get(&val));
+    }
+    /**
+     * Put an item into the queue.
+     * If the queue is full, this will block the caller until items are
+     * removed bringing the size less than the capacity.
+     * @param val The value to add to the queue.
+     * @throw queue_closed if the queue is closed.
+     */
+    void put(value_type val) {
+        if (!put_until(val, static_cast<const steady_time_point*>(nullptr)))
+            throw queue_closed{};
+    }
+    /**
+     * Non-blocking attempt to place an item into the queue.
+     * @param val The value to add to the queue.
+     * @return @em true if the item was added to the queue, @em false if the
+     *  	   item was not added because the queue is currently full or
+     *  	   closed.
+     */
+    bool try_put(value_type val) {
+        return !closed_.load(std::memory_order_acquire) && do_put(val);
+    }
+    /**
+     * Attempt to place an item in the queue with a bounded wait.
+     * @param val The value to add to the queue.
+     * @param relTime The amount of time to wait until timing out.
+     * @return @em true if the value was added to the queue, @em false if a
+     *  	   timeout occurred.
+     */
+    template <typename Rep, class Period>
+    bool try_put_for(value_type val, const std::chrono::duration<Rep, Period>& relTime) {
+        auto absTime = std::chrono::steady_clock::now() + relTime;
+        return put_until(val, &absTime);
+    }
+    /**
+     * Attempt to place an item in the queue with a bounded wait to an
+     * absolute time point.
+     * @param val The value to add to the queue.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return @em true if the value was added to the queue, @em false if a
+     *  	   timeout occurred.
+     */
+    template <class Clock, class Duration>
+    bool try_put_until(
+        value_type val, const std::chrono::time_point<Clock, Duration>& absTime
+    ) {
+        return put_until(val, &absTime);
+    }
+    /**
+     * Retrieve a value from the queue.
+     * If the queue is empty, this will block indefinitely until a value is
+     * added to the queue by another thread,
+     * @param val Pointer to a variable to receive the value.
+     * @return @em true if a value was retrieved, @em false if the queue is
+     *  	   closed and empty.
+     */
+    bool get(value_type* val) {
+        if (!val)
+            return false;
+        return get_until(val, static_cast<const steady_time_point*>(nullptr));
+    }
+    /**
+     * Retrieve a value from the queue.
+     * If the queue is empty, this will block indefinitely until a value is
+     * added to the queue by another thread,
+     * @return The value removed from the queue
+     * @throw queue_closed if the queue is closed and empty.
+     */
+    value_type get() {
+        value_type val;
+        if (!get_until(&val, static_cast<const steady_time_point*>(nullptr)))
+            throw queue_closed{};
+        return val;
+    }
+    /**
+     * Attempts to remove a value from the queue without blocking.
+     * @param val Pointer to a variable to receive the value.
+     * @return @em true if a value was removed from the queue, @em false if
+     *  	   the queue is empty.
+     */
+    bool try_get(value_type* val) {
+        if (!val)
+            return false;
+        return do_get(val);
+    }
+    /**
+     * Attempt to remove an item from the queue for a bounded amount of time.
+     * @param val Pointer to a variable to receive the value.
+     * @param relTime The amount of time to wait until timing out.
+     * @return @em true if the value was removed the queue, @em false if a
+     *  	   timeout occurred.
+     */
+    template <typename Rep, class Period>
+    bool try_get_for(value_type* val, const std::chrono::duration<Rep, Period>& relTime) {
+        if (!val)
+            return false;
+        auto absTime = std::chrono::steady_clock::now() + relTime;
+        return get_until(val, &absTime);
+    }
+    /**
+     * Attempt to remove an item from the queue until an absolute time.
+     * @param val Pointer to a variable to receive the value.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return @em true if the value was removed from the queue, @em false
+     *  	   if a timeout occurred.
+     */
+    template <class Clock, class Duration>
+    bool try_get_until(
+        value_type* val, const std::chrono::time_point<Clock, Duration>& absTime
+    ) {
+        if (!val)
+            return false;
+        return get_until(val, &absTime);
+    }
+    /**
+     * Retrieve a batch of values from the queue.
+     * If the queue is empty, this will block until a value is added to the
+     * queue by another thread. Then it moves as many items as are
+     * available, up to the requested number.
+     * @param vec The vector to receive the values. They are appended to
+     *  		  the back.
+     * @param n The maximum number of values to retrieve.
+     * @return The number of values retrieved. This is only zero if the
+     *  	   queue is closed and empty, or if @em n is zero.
+     */
+    size_type get_n(std::vector<value_type>& vec, size_type n) {
+        return first_n(vec, n, static_cast<const steady_time_point*>(nullptr));
+    }
+    /**
+     * Attempts to remove a batch of values from the queue without
+     * blocking.
+     * @param vec The vector to receive the values. They are appended to
+     *  		  the back.
+     * @param n The maximum number of values to retrieve.
+     * @return The number of values retrieved, which is zero if the queue
+     *  	   is empty.
+     */
+    size_type try_get_n(std::vector<value_type>& vec, size_type n) {
+        size_type i = 0;
+        value_type val;
+        while (i < n && do_get(&val)) {
+            vec.push_back(std::move(val));
+            ++i;
+        }
+        return i;
+    }
+    /**
+     * Attempt to remove a batch of values from the queue, waiting a
+     * bounded amount of time for the first one to arrive.
+     * @param vec The vector to receive the values.
+     * @param n The maximum number of values to retrieve.
+     * @param relTime The amount of time to wait until timing out.
+     * @return The number of values retrieved, which is zero on timeout.
+     */
+    template <typename Rep, class Period>
+    size_type try_get_n_for(
+        std::vector<value_type>& vec, size_type n,
+        const std::chrono::duration<Rep, Period>& relTime
+    ) {
+        auto absTime = std::chrono::steady_clock::now() + relTime;
+        return first_n(vec, n, &absTime);
+    }
+    /**
+     * Attempt to remove a batch of values from the queue, waiting until
+     * an absolute time for the first one to arrive.
+     * @param vec The vector to receive the values.
+     * @param n The maximum number of values to retrieve.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return The number of values retrieved, which is zero on timeout.
+     */
+    template <class Clock, class Duration>
+    size_type try_get_n_until(
+        std::vector<value_type>& vec, size_type n,
+        const std::chrono::time_point<Clock, Duration>& absTime
+    ) {
+        return first_n(vec, n, &absTime);
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_ring_queue_h
@@ -0,0 +1,199 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file sharded_dispatcher.h
+/// Declaration of MQTT sharded_dispatcher class, which spreads incoming
+/// messages over a pool of worker threads, keeping the order of messages
+/// with the same key.
+/// @date 16-Oct-2026
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_sharded_dispatcher_h
+#define __mqtt_sharded_dispatcher_h
+
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "mqtt/message.h"
+#include "mqtt/thread_queue.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Options for a @ref sharded_dispatcher.
+ */
+struct dispatch_options
+{
+    /** Function to get the sharding key of a message. */
+    using key_function = std::function<std::size_t(const message&)>;
+
+    /**
+     * The function to get the key of a message, which selects the worker
+     * that handles it. Messages with the same key are always handled by
+     * the same worker, in the order that they arrived. If this is empty,
+     * the messages are keyed by topic.
+     */
+    key_function key;
+    /**
+     * The CPUs to pin the worker threads to. Worker @em i is pinned to
+     * `cpus[i % cpus.size()]`. If this is empty, the workers can run on
+     * any CPU. This is currently only supported on Linux, and ignored on
+     * other platforms.
+     */
+    std::vector<int> cpus;
+    /**
+     * The name prefix for the worker threads. Each thread is named with
+     * the prefix followed by its index, truncated to the length allowed by
+     * the system. If this is empty, the threads are not named. This is
+     * currently only supported on Linux, and ignored on other platforms.
+     */
+    string threadName;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Dispatches messages to a handler running on a pool of worker threads.
+ *
+ * Each message is hashed by a key onto one of the workers, and each worker
+ * has its own queue. So messages with the same key, by default the same
+ * topic, are always processed in order by the same thread, while messages
+ * with different keys can be processed in parallel.
+ * @par
+ * The worker threads are started when the dispatcher is created, and are
+ * stopped when it is destroyed, or by calling @ref stop().
+ */
+class sharded_dispatcher
+{
+public:
+    /** Smart/unique pointer to an object of this class. */
+    using ptr_t = std::unique_ptr<sharded_dispatcher>;
+    /** Handler type for the messages */
+    using handler_type = std::function<void(const_message_ptr)>;
+    /** Function to get the sharding key of a message. */
+    using key_function = dispatch_options::key_function;
+
+private:
+    /** A message queued for a worker, with its own handler, if any */
+    struct work_item
+    {
+        /** The message */
+        const_message_ptr msg;
+        /** The handler for the message, or empty for the default one */
+        handler_type handler;
+    };
+    /** A worker thread and its queue */
+    struct worker
+    {
+        /** The queue of messages for the worker */
+        thread_queue<work_item> que;
+        /** The worker thread */
+        std::thread thr;
+    };
+
+    /** The handler for the messages. Shared with the worker threads. */
+    std::shared_ptr<const handler_type> handler_;
+    /** The function to get the key of a message */
+    key_function keyFn_;
+    /**
+     * The workers. Each thread shares its own worker and the handler, and
+     * doesn't touch the dispatcher, so it can't outlive what it uses.
+     */
+    std::vector<std::shared_ptr<worker>> workers_;
+
+    /** The worker thread function */
+    static void run(std::shared_ptr<worker> w, std::shared_ptr<const handler_type> handler);
+
+public:
+    /**
+     * Creates a dispatcher and starts the worker threads.
+     * @param nWorkers The number of worker threads. The minimum is one.
+     * @param handler The handler for the messages.
+     * @param opts The dispatch options.
+     */
+    sharded_dispatcher(
+        std::size_t nWorkers, handler_type handler,
+        const dispatch_options& opts = dispatch_options{}
+    );
+    /**
+     * Stops the workers and destroys the dispatcher.
+     * This waits for all the worker threads to exit, including one that
+     * stopped the dispatcher from its handler. If the dispatcher is
+     * destroyed by one of its own handlers, that worker is left to finish
+     * on its own, since it can't wait for itself.
+     */
+    ~sharded_dispatcher();
+
+    sharded_dispatcher(const sharded_dispatcher&) = delete;
+    sharded_dispatcher& operator=(const sharded_dispatcher&) = delete;
+
+    /**
+     * Gets the default key for a message, which is a hash of its topic.
+     * @param msg The message.
+     * @return A hash of the message topic.
+     */
+    static std::size_t topic_key(const message& msg);
+    /**
+     * Gets the number of worker threads.
+     * @return The number of worker threads.
+     */
+    std::size_t size() const { return workers_.size(); }
+    /**
+     * Gets the index of the worker that handles the message.
+     * @param msg The message.
+     * @return The index of the worker that handles the message.
+     */
+    std::size_t shard_of(const message& msg) const;
+    /**
+     * Queues a message for its worker.
+     * This does not block.
+     * @param msg The message.
+     * @throw queue_closed if the dispatcher was stopped.
+     */
+    void dispatch(const_message_ptr msg);
+    /**
+     * Queues a message for its worker, to be sent to a specific handler
+     * rather than the dispatcher's handler.
+     * This does not block.
+     * @param msg The message.
+     * @param handler The handler for this message.
+     * @throw queue_closed if the dispatcher was stopped.
+     */
+    void dispatch(const_message_ptr msg, handler_type handler);
+    /**
+     * Stops the workers.
+     * The workers will finish handling any messages already queued for
+     * them, then exit. This blocks until they are done. When called from
+     * a handler, it waits for all the other workers, and the calling
+     * worker exits after its handler returns. Its thread is then joined
+     * when the dispatcher is destroyed.
+     */
+    void stop();
+};
+
+/** Smart/unique pointer to a sharded dispatcher */
+using sharded_dispatcher_ptr = sharded_dispatcher::ptr_t;
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_sharded_dispatcher_h
@@ -26,12 +26,26 @@
 #define __mqtt_thread_queue_h
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <deque>
+#include <functional>
 #include <limits>
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <vector>
+
+#if defined(__linux__)
+    #include <sys/eventfd.h>
+    #include <unistd.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+#endif
 
 namespace mqtt {
 
@@ -45,6 +59,63 @@ public:
     queue_closed() : std::runtime_error("queue is closed") {}
 };
 
+/**
+ * Hints to the CPU that the caller is busy-waiting in a spin loop.
+ * This is the `pause` instruction on x86, and `yield` on ARM, which lets
+ * the core save power and avoid memory-order mis-speculation when the loop
+ * exits. It does nothing on other platforms.
+ */
+inline void cpu_relax() noexcept {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/**
+ * Statistics about the traffic through a queue.
+ * These are optional for a queue, and must be enabled to be kept, except
+ * for the current depth, which is always available.
+ */
+struct queue_stats
+{
+    /** The total number of items put into the queue */
+    uint64_t enqueued{0};
+    /** The total number of items removed from the queue by readers */
+    uint64_t dequeued{0};
+    /** The current number of items in the queue */
+    std::size_t depth{0};
+    /** The highest number of items that were in the queue at once */
+    std::size_t maxDepth{0};
+    /** The total time that producers were blocked putting items */
+    std::chrono::nanoseconds putBlockedTime{0};
+    /** The total time that consumers waited for items to arrive */
+    std::chrono::nanoseconds getWaitTime{0};
+    /** How long the item at the head of the queue has been waiting */
+    std::chrono::nanoseconds headAge{0};
+};
+
+/**
+ * What a bounded queue should do when an item is put into it while it is
+ * full.
+ */
+enum class overflow_policy {
+    /** Block the caller until there is space in the queue (the default) */
+    block,
+    /** Discard the item at the front of the queue to make room */
+    drop_oldest,
+    /** Discard the item being put into the queue */
+    drop_newest,
+    /**
+     * Block the caller up to a deadline, then discard the item being put
+     * into the queue.
+     */
+    block_with_deadline
+};
+
 /////////////////////////////////////////////////////////////////////////////
 
 /**
@@ -63,6 +134,41 @@ public:
  * queue will block until the number of items are removed from the queue to
  * bring the size below the new capacity.
  * @par
+ * What happens when a `put()` is made on a full queue is determined by the
+ * queue's @ref overflow_policy. By default the caller blocks, but the
+ * queue can be told to discard the oldest or newest item instead, or to
+ * block only for a limited time before discarding the new item. The number
+ * of items discarded is kept by the queue, and can be read with
+ * @ref dropped(). The overflow policy only applies to `put()`. The
+ * `try_put()` variations always fail without discarding anything.
+ * @par
+ * The capacity can also be measured in bytes, using a function that gets
+ * the size of each item, set with @ref byte_capacity(). Then a `put()` will
+ * also block (or apply the overflow policy) if adding the item would push
+ * the total size of the items in the queue over the byte budget, and the
+ * `try_put()` variations will fail. An item larger than the whole budget
+ * is still accepted when the queue is empty, so that it can't block
+ * forever.
+ * @par
+ * By default, a blocked caller is put to sleep on a condition variable
+ * right away. For latency-sensitive applications, the queue can instead be
+ * told to spin for a while, checking for the condition with the CPU
+ * `pause` instruction, then to yield the processor a number of times,
+ * before going to sleep. This is set with @ref spin_budget(), and applies
+ * to the blocking `get()` and `put()` calls. It can avoid the cost of
+ * sleeping and waking a thread when items arrive at a moderate rate, at
+ * the cost of the CPU time spent spinning.
+ * @par
+ * The queue can keep statistics about its traffic, such as the number of
+ * items that passed through it, its high-water depth, the time that
+ * callers spent blocked, and the age of the item at the head of the queue.
+ * These are enabled with @ref enable_stats(), and can be read at any time
+ * without the lock with @ref stats().
+ * @par
+ * The queue also has a priority lane, for urgent items. Those placed with
+ * `put_priority()` are handed out before any of the others, ignoring the
+ * capacity of the queue.
+ * @par
  * The queue can be closed. After that, no new items can be placed into it;
  * a `put()` calls will fail. Receivers can still continue to get any items
  * out of the queue that were added before it was closed. Once there are no
@@ -94,6 +200,8 @@ public:
 
     /** The maximum capacity of the queue. */
     static constexpr size_type MAX_CAPACITY = std::numeric_limits<size_type>::max();
+    /** Function type to get the size of an item, in bytes */
+    using size_function = std::function<std::size_t(const value_type&)>;
 
 private:
     /** Object lock */
@@ -104,20 +212,282 @@ private:
     std::condition_variable notFullCond_;
     /** The capacity of the queue */
     size_type cap_{MAX_CAPACITY};
-    /** Whether the queue is closed */
-    bool closed_{false};
+    /** Whether the queue is closed. Atomic so a spinning putter can see it */
+    std::atomic<bool> closed_{false};
+    /** What put() does when the queue is full */
+    overflow_policy policy_{overflow_policy::block};
+    /** How long put() blocks before dropping, for block_with_deadline */
+    std::chrono::nanoseconds deadline_{0};
+    /** The number of items discarded due to overflow */
+    size_type dropped_{0};
+    /** The function to get the size of an item, in bytes (if any) */
+    size_function sizeFn_;
+    /** The capacity of the queue in bytes */
+    std::size_t byteCap_{std::numeric_limits<std::size_t>::max()};
+    /** The total size of the items in the queue, in bytes */
+    std::size_t nBytes_{0};
 
     /** The actual STL container to hold data */
     std::queue<T, Container> que_;
+    /** The priority lane, for items that bypass the others */
+    std::deque<T> prioQue_;
+    /** Pollable file descriptor that is readable when not empty (if any) */
+    int notifyFd_{-1};
+    /** The number of items in the queue, for checks without the lock */
+    std::atomic<size_type> nItems_{0};
+    /** The number of items in the normal lane, for checks without the lock */
+    std::atomic<size_type> nNormal_{0};
+    /** The total size of the items in bytes, for checks without the lock */
+    std::atomic<std::size_t> nBytesNow_{0};
+    /** The number of times to spin before yielding, when blocked */
+    std::atomic<unsigned> nSpin_{0};
+    /** The number of times to yield before sleeping, when blocked */
+    std::atomic<unsigned> nYield_{0};
+    /** Whether statistics are kept */
+    std::atomic<bool> statsOn_{false};
+    /** The total number of items put into the queue */
+    std::atomic<uint64_t> nEnqueued_{0};
+    /** The total number of items removed by readers */
+    std::atomic<uint64_t> nDequeued_{0};
+    /** The high-water mark of the number of items in the queue */
+    std::atomic<size_type> maxDepth_{0};
+    /** The total time producers were blocked, in nanoseconds */
+    std::atomic<int64_t> putBlockedNs_{0};
+    /** The total time consumers waited, in nanoseconds */
+    std::atomic<int64_t> getWaitNs_{0};
+    /** The time the head item was enqueued, in steady clock nanoseconds */
+    std::atomic<int64_t> headStamp_{0};
+    /** The times that the items in the normal lane were enqueued */
+    std::deque<std::chrono::steady_clock::time_point> stamps_;
+
+    /**
+     * Scope-based timer that adds the time that a caller spent waiting to
+     * one of the statistics.
+     */
+    class wait_timer
+    {
+        std::atomic<int64_t>* total_;
+        std::chrono::steady_clock::time_point start_;
+
+    public:
+        wait_timer(bool on, std::atomic<int64_t>& total) : total_{on ? &total : nullptr} {
+            if (on)
+                start_ = std::chrono::steady_clock::now();
+        }
+        ~wait_timer() {
+            if (total_) {
+                auto dur = std::chrono::steady_clock::now() - start_;
+                total_->fetch_add(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(dur).count(),
+                    std::memory_order_relaxed
+                );
+            }
+        }
+    };
+    /** Determines if statistics are being kept */
+    bool stats_on() const { return statsOn_.load(std::memory_order_relaxed); }
 
     /** Simple, scope-based lock guard */
     using guard = std::lock_guard<std::mutex>;
     /** General purpose guard */
     using unique_guard = std::unique_lock<std::mutex>;
 
+    /** Checks if there are items in either lane of the queue (unsafe) */
+    bool has_items() const {
+        return !prioQue_.empty() || !que_.empty();
+    }
     /** Checks if the queue is done (unsafe) */
     bool is_done() const {
-        return closed_ && que_.empty();
+        return closed_ && !has_items();
+    }
+    /** Gets the size of an item in bytes, if there's a byte budget (unsafe) */
+    std::size_t item_bytes(const value_type& val) const {
+        return sizeFn_ ? sizeFn_(val) : 0;
+    }
+    /**
+     * Determines if there is room in the queue for another item of the
+     * specified size (unsafe).
+     */
+    bool has_room(std::size_t nBytes) const {
+        return que_.size() < cap_ && (nBytes_ + nBytes <= byteCap_ || que_.empty());
+    }
+    /** Wakes putters after items were removed from the queue (unsafe) */
+    void notify_not_full(size_type n) {
+        // With a byte budget, a big item could make room for several others
+        if (n > 1 || (n == 1 && sizeFn_))
+            notFullCond_.notify_all();
+        else if (n == 1)
+            notFullCond_.notify_one();
+    }
+    /**
+     * Removes the item at the front of the normal lane (unsafe).
+     * This doesn't update the counts or signal anyone.
+     */
+    value_type pop_front_item() {
+        value_type val = std::move(que_.front());
+        que_.pop();
+        nBytes_ -= item_bytes(val);
+        if (!stamps_.empty())
+            stamps_.pop_front();
+        return val;
+    }
+    /** Adds an item to the back of the normal lane and signals (unsafe) */
+    void push_item(value_type&& val, std::size_t nBytes) {
+        auto n = que_.size();
+        nBytes_ += nBytes;
+        que_.emplace(std::move(val));
+
+        // If the container replaced an existing item, it's now in 'val'
+        if (que_.size() == n)
+            nBytes_ -= item_bytes(val);
+        else if (stats_on())
+            stamps_.push_back(std::chrono::steady_clock::now());
+
+        notify_not_empty();
+    }
+    /** Updates the counts that can be read without the lock (unsafe) */
+    void update_count() {
+        auto n = que_.size() + prioQue_.size();
+        nNormal_.store(que_.size(), std::memory_order_release);
+        nBytesNow_.store(nBytes_, std::memory_order_release);
+        nItems_.store(n, std::memory_order_release);
+
+        if (stats_on()) {
+            if (n > maxDepth_.load(std::memory_order_relaxed))
+                maxDepth_.store(n, std::memory_order_relaxed);
+
+            using std::chrono::nanoseconds;
+            int64_t stamp = 0;
+            if (!stamps_.empty()) {
+                auto t = stamps_.front().time_since_epoch();
+                stamp = std::chrono::duration_cast<nanoseconds>(t).count();
+            }
+            headStamp_.store(stamp, std::memory_order_relaxed);
+        }
+    }
+    /**
+     * Spins, then yields, up to the spin budget of the queue, until the
+     * predicate is true. This is done without the lock.
+     * @return @em true if the predicate became true, @em false if the
+     *  	   budget ran out.
+     */
+    template <typename Pred>
+    bool spin_until(Pred pred) const {
+        for (auto n = nSpin_.load(std::memory_order_relaxed); n > 0; --n) {
+            if (pred())
+                return true;
+            cpu_relax();
+        }
+        for (auto n = nYield_.load(std::memory_order_relaxed); n > 0; --n) {
+            if (pred())
+                return true;
+            std::this_thread::yield();
+        }
+        return pred();
+    }
+    /**
+     * Spins until there is an item in the queue, the queue is closed, or
+     * the budget runs out.
+     */
+    void spin_not_empty() const {
+        if (nSpin_.load(std::memory_order_relaxed) ||
+            nYield_.load(std::memory_order_relaxed)) {
+            spin_until([this] {
+                return nItems_.load(std::memory_order_acquire) != 0 ||
+                       closed_.load(std::memory_order_acquire);
+            });
+        }
+    }
+    /** Makes the notification descriptor readable, if there is one (unsafe) */
+    void signal_notify_fd() {
+#if defined(__linux__)
+        if (notifyFd_ >= 0) {
+            uint64_t n = 1;
+            auto ret = ::write(notifyFd_, &n, sizeof(n));
+            (void)ret;
+        }
+#endif
+    }
+    /**
+     * Signals that an item was added to the queue (unsafe).
+     * This wakes a waiting getter and, if the queue just went from empty
+     * to non-empty, makes the notification descriptor readable.
+     */
+    void notify_not_empty() {
+        if (stats_on())
+            nEnqueued_.fetch_add(1, std::memory_order_relaxed);
+        update_count();
+        notEmptyCond_.notify_one();
+        if (que_.size() + prioQue_.size() == 1)
+            signal_notify_fd();
+    }
+    /**
+     * Resets the notification descriptor if the queue is now empty, so
+     * that it is no longer readable (unsafe).
+     * Once the queue is closed, the descriptor stays readable.
+     */
+    void reset_notify_fd() {
+#if defined(__linux__)
+        if (notifyFd_ >= 0 && !has_items() && !closed_) {
+            uint64_t n;
+            auto ret = ::read(notifyFd_, &n, sizeof(n));
+            (void)ret;
+        }
+#endif
+    }
+    /** Updates the counts after items were removed by a reader (unsafe) */
+    void count_dequeued(size_type n) {
+        if (stats_on())
+            nDequeued_.fetch_add(n, std::memory_order_relaxed);
+        update_count();
+    }
+    /**
+     * Removes the next item from the queue, taking it from the priority
+     * lane first (unsafe).
+     * The queue must not be empty.
+     */
+    value_type pop_next() {
+        if (!prioQue_.empty()) {
+            value_type val = std::move(prioQue_.front());
+            prioQue_.pop_front();
+            nBytes_ -= item_bytes(val);
+            count_dequeued(1);
+            // Priority items don't take a slot, but they do use the budget
+            if (sizeFn_)
+                notFullCond_.notify_all();
+            reset_notify_fd();
+            return val;
+        }
+        value_type val = pop_front_item();
+        count_dequeued(1);
+        notify_not_full(1);
+        reset_notify_fd();
+        return val;
+    }
+    /**
+     * Moves up to n items from the front of the queue to the back of the
+     * vector (unsafe).
+     * @return The number of items moved.
+     */
+    size_type move_n(std::vector<value_type>& vec, size_type n) {
+        size_type i = 0;
+        for (; i < n && !prioQue_.empty(); ++i) {
+            vec.push_back(std::move(prioQue_.front()));
+            prioQue_.pop_front();
+            nBytes_ -= item_bytes(vec.back());
+        }
+        size_type nPrio = i;
+        for (; i < n && !que_.empty(); ++i) vec.push_back(pop_front_item());
+
+        if (nPrio > 0 && sizeFn_)
+            notFullCond_.notify_all();
+        else
+            notify_not_full(i - nPrio);
+        if (i > 0) {
+            count_dequeued(i);
+            reset_notify_fd();
+        }
+        return i;
     }
 
 public:
@@ -133,6 +503,61 @@ public:
      *  		  queue. The minimum capacity is 1.
      */
     explicit thread_queue(size_t cap) : cap_(std::max<size_type>(cap, 1)) {}
+    /**
+     * Constructs a bounded queue with the specified capacity and overflow
+     * policy.
+     * @param cap The maximum number of items that can be placed in the
+     *  		  queue. The minimum capacity is 1.
+     * @param policy What to do when an item is put into a full queue.
+     * @param deadline The maximum time that a put() will block before
+     *  			   dropping the new item, when the policy is
+     *  			   @em block_with_deadline.
+     */
+    template <typename Rep = long long, class Period = std::nano>
+    thread_queue(
+        size_t cap, overflow_policy policy,
+        const std::chrono::duration<Rep, Period>& deadline = std::chrono::nanoseconds{0}
+    )
+        : cap_(std::max<size_type>(cap, 1)),
+          policy_(policy),
+          deadline_(std::chrono::duration_cast<std::chrono::nanoseconds>(deadline)) {}
+    /**
+     * Destroys the queue, closing the notification descriptor, if any.
+     */
+    ~thread_queue() {
+#if defined(__linux__)
+        if (notifyFd_ >= 0)
+            ::close(notifyFd_);
+#endif
+    }
+    /**
+     * Gets a file descriptor that can be polled to find out when there are
+     * items in the queue.
+     * The descriptor is created on the first call, and is owned by the
+     * queue. It is readable, with `poll()`, `select()`, or `epoll`, while
+     * there are items in the queue, and after the queue is closed. It is
+     * meant to be used with a non-blocking reader, such as
+     * @ref try_get_n(), which should drain the queue each time it is
+     * signaled. The application should not read from or write to the
+     * descriptor itself.
+     * @par
+     * This uses a Linux `eventfd`. On other platforms it is not supported.
+     * @return The file descriptor, or -1 if this is not supported or the
+     *  	   descriptor could not be created.
+     */
+    int notify_fd() {
+#if defined(__linux__)
+        guard g{lock_};
+        if (notifyFd_ < 0) {
+            notifyFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (has_items() || closed_)
+                signal_notify_fd();
+        }
+        return notifyFd_;
+#else
+        return -1;
+#endif
+    }
     /**
      * Determine if the queue is empty.
      * @return @em true if there are no elements in the queue, @em false if
@@ -140,7 +565,7 @@ public:
      */
     bool empty() const {
         guard g{lock_};
-        return que_.empty();
+        return !has_items();
     }
     /**
      * Gets the capacity of the queue.
@@ -166,7 +591,184 @@ public:
      */
     size_type size() const {
         guard g{lock_};
-        return que_.size();
+        return que_.size() + prioQue_.size();
+    }
+    /**
+     * Gets the capacity of the queue in bytes.
+     * @return The maximum total size of the items in the queue, in bytes.
+     *  	   This is the maximum value of `size_t` if the queue has no
+     *  	   byte budget.
+     */
+    std::size_t byte_capacity() const {
+        guard g{lock_};
+        return byteCap_;
+    }
+    /**
+     * Sets a capacity for the queue in bytes.
+     * This is in addition to the capacity as a number of items. The total
+     * size of the items in the queue is kept using the size function, so it
+     * must always return the same size for the same item. This is best set
+     * while the queue is empty, since any items already in the queue need
+     * to be counted.
+     * @param cap The maximum total size of the items in the queue, in
+     *  		  bytes.
+     * @param sizeFn A function to get the size of an item, in bytes. If
+     *  			 this is empty, the byte budget is removed.
+     */
+    void byte_capacity(std::size_t cap, size_function sizeFn) {
+        guard g{lock_};
+        sizeFn_ = std::move(sizeFn);
+        byteCap_ = sizeFn_ ? cap : std::numeric_limits<std::size_t>::max();
+
+        // Recount anything that's already in the queue
+        nBytes_ = 0;
+        if (sizeFn_) {
+            for (const auto& val : prioQue_) nBytes_ += sizeFn_(val);
+
+            std::deque<T> tmp;
+            while (!que_.empty()) {
+                nBytes_ += sizeFn_(que_.front());
+                tmp.push_back(std::move(que_.front()));
+                que_.pop();
+            }
+            for (auto& val : tmp) que_.push(std::move(val));
+        }
+        update_count();
+        notFullCond_.notify_all();
+    }
+    /**
+     * Gets the total size of the items in the queue, in bytes.
+     * This is only kept if the queue has a byte capacity.
+     * @return The total size of the items in the queue, in bytes.
+     */
+    std::size_t size_bytes() const {
+        guard g{lock_};
+        return nBytes_;
+    }
+    /**
+     * Gets the number of items in the priority lane of the queue.
+     * This is a constant-time operation, regardless of the number of items
+     * waiting in the normal lane.
+     * @return The number of items in the priority lane.
+     */
+    size_type priority_size() const {
+        guard g{lock_};
+        return prioQue_.size();
+    }
+    /**
+     * Gets the overflow policy of the queue.
+     * @return What a put() does when the queue is full.
+     */
+    overflow_policy overflow() const {
+        guard g{lock_};
+        return policy_;
+    }
+    /**
+     * Sets the overflow policy of the queue.
+     * @param policy What to do when an item is put into a full queue.
+     * @param deadline The maximum time that a put() will block before
+     *  			   dropping the new item, when the policy is
+     *  			   @em block_with_deadline.
+     */
+    template <typename Rep = long long, class Period = std::nano>
+    void overflow(
+        overflow_policy policy,
+        const std::chrono::duration<Rep, Period>& deadline = std::chrono::nanoseconds{0}
+    ) {
+        guard g{lock_};
+        policy_ = policy;
+        deadline_ = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline);
+        notFullCond_.notify_all();
+    }
+    /**
+     * Gets the number of items that were discarded by put() because the
+     * queue was full.
+     * @return The number of items dropped due to overflow.
+     */
+    size_type dropped() const {
+        guard g{lock_};
+        return dropped_;
+    }
+    /**
+     * Gets the number of times that a blocked call spins before yielding
+     * the CPU.
+     * @return The spin count of the adaptive wait.
+     */
+    unsigned spin_budget() const { return nSpin_.load(std::memory_order_relaxed); }
+    /**
+     * Sets the adaptive wait strategy for blocking calls.
+     * When a blocking `get()` or `put()` can not proceed, it will first spin
+     * for up to @em nSpin checks, then yield the CPU up to @em nYield
+     * times, before going to sleep until it is signaled. Setting both to
+     * zero, which is the default, goes straight to sleep.
+     * @param nSpin The number of times to spin, using the CPU `pause`
+     *  			instruction between checks. A few thousand is
+     *  			typically a few microseconds.
+     * @param nYield The number of times to yield the CPU after spinning.
+     */
+    void spin_budget(unsigned nSpin, unsigned nYield = 0) {
+        nSpin_.store(nSpin, std::memory_order_relaxed);
+        nYield_.store(nYield, std::memory_order_relaxed);
+    }
+    /**
+     * Determines if the queue is keeping statistics.
+     * @return @em true if the queue is keeping statistics.
+     */
+    bool stats_enabled() const { return stats_on(); }
+    /**
+     * Turns the statistics for the queue on or off.
+     * Keeping statistics adds a small amount of overhead to each operation,
+     * mostly to read the clock, so it is off by default. Items already in
+     * the queue when statistics are turned on are treated as if they were
+     * just enqueued.
+     * @param on Whether to keep statistics.
+     */
+    void enable_stats(bool on = true) {
+        guard g{lock_};
+        statsOn_.store(on, std::memory_order_relaxed);
+        stamps_.clear();
+        if (on)
+            stamps_.resize(que_.size(), std::chrono::steady_clock::now());
+        else
+            headStamp_.store(0, std::memory_order_relaxed);
+        update_count();
+    }
+    /**
+     * Gets the statistics for the queue.
+     * This does not acquire the lock on the queue, so the values are each
+     * current, but not necessarily consistent with each other.
+     * @return The statistics for the queue.
+     */
+    queue_stats stats() const {
+        using namespace std::chrono;
+
+        queue_stats st;
+        st.enqueued = nEnqueued_.load(std::memory_order_relaxed);
+        st.dequeued = nDequeued_.load(std::memory_order_relaxed);
+        st.depth = nItems_.load(std::memory_order_acquire);
+        st.maxDepth = maxDepth_.load(std::memory_order_relaxed);
+        st.putBlockedTime = nanoseconds{putBlockedNs_.load(std::memory_order_relaxed)};
+        st.getWaitTime = nanoseconds{getWaitNs_.load(std::memory_order_relaxed)};
+
+        auto stamp = headStamp_.load(std::memory_order_relaxed);
+        if (stamp != 0) {
+            auto now = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch());
+            st.headAge = std::max(now - nanoseconds{stamp}, nanoseconds{0});
+        }
+        return st;
+    }
+    /**
+     * Resets the statistics for the queue.
+     * The counters and times are set to zero, and the high-water mark is
+     * set to the current depth of the queue.
+     */
+    void reset_stats() {
+        guard g{lock_};
+        nEnqueued_.store(0, std::memory_order_relaxed);
+        nDequeued_.store(0, std::memory_order_relaxed);
+        maxDepth_.store(que_.size() + prioQue_.size(), std::memory_order_relaxed);
+        putBlockedNs_.store(0, std::memory_order_relaxed);
+        getWaitNs_.store(0, std::memory_order_relaxed);
     }
     /**
      * Close the queue.
@@ -179,6 +781,7 @@ public:
         closed_ = true;
         notFullCond_.notify_all();
         notEmptyCond_.notify_all();
+        signal_notify_fd();
     }
     /**
      * Determines if the queue is closed.
@@ -209,21 +812,110 @@ public:
         guard g{lock_};
         while (!que_.empty())
             que_.pop();
+        prioQue_.clear();
+        stamps_.clear();
+        nBytes_ = 0;
+        update_count();
+        reset_notify_fd();
         notFullCond_.notify_all();
     }
     /**
      * Put an item into the queue.
-     * If the queue is full, this will block the caller until items are
-     * removed bringing the size less than the capacity.
+     * If the queue is full, this will apply the queue's overflow policy.
+     * By default that will block the caller until items are removed
+     * bringing the size less than the capacity.
      * @param val The value to add to the queue.
+     * @throw queue_closed if the queue is closed.
      */
     void put(value_type val) {
         unique_guard g{lock_};
-        notFullCond_.wait(g, [this] { return que_.size() < cap_ || closed_; });
         if (closed_) throw queue_closed{};
 
-        que_.emplace(std::move(val));
-        notEmptyCond_.notify_one();
+        auto nBytes = item_bytes(val);
+        auto notFull = [this, nBytes] { return has_room(nBytes) || closed_; };
+
+        bool blocks = policy_ == overflow_policy::block ||
+                      policy_ == overflow_policy::block_with_deadline;
+        wait_timer timer{stats_on() && blocks && !notFull(), putBlockedNs_};
+
+        switch (policy_) {
+            case overflow_policy::block:
+                if (!notFull() && (nSpin_ || nYield_)) {
+                    // The same check as has_room(), on the lock-free counts
+                    size_type cap = cap_;
+                    std::size_t byteCap = byteCap_;
+                    g.unlock();
+                    spin_until([this, cap, byteCap, nBytes] {
+                        auto n = nNormal_.load(std::memory_order_acquire);
+                        auto nb = nBytesNow_.load(std::memory_order_acquire);
+                        return closed_.load(std::memory_order_acquire) ||
+                               (n < cap && (nb + nBytes <= byteCap || n == 0));
+                    });
+                    g.lock();
+                }
+                notFullCond_.wait(g, notFull);
+                break;
+
+            case overflow_policy::drop_oldest:
+                while (!notFull() && !que_.empty()) {
+                    pop_front_item();
+                    ++dropped_;
+                }
+                break;
+
+            case overflow_policy::drop_newest:
+                if (!notFull()) {
+                    ++dropped_;
+                    return;
+                }
+                break;
+
+            case overflow_policy::block_with_deadline:
+                if (!notFullCond_.wait_for(g, deadline_, notFull)) {
+                    ++dropped_;
+                    return;
+                }
+                break;
+        }
+
+        if (closed_) throw queue_closed{};
+
+        push_item(std::move(val), nBytes);
+    }
+    /**
+     * Put an item into the priority lane of the queue.
+     * Items in the priority lane are removed from the queue before any
+     * items that were put into it normally, but otherwise they are kept in
+     * order. The priority lane is not limited by the capacity of the queue,
+     * and is not subject to the overflow policy, so this never blocks.
+     * It is meant for occasional, urgent items, like notifications.
+     * @param val The value to add to the queue.
+     * @throw queue_closed if the queue is closed.
+     */
+    void put_priority(value_type val) {
+        guard g{lock_};
+        if (closed_) throw queue_closed{};
+
+        nBytes_ += item_bytes(val);
+        prioQue_.push_back(std::move(val));
+        notify_not_empty();
+    }
+    /**
+     * Put an item into the queue, even if it's full.
+     * The item is kept in order with the others put into the queue
+     * normally, but it's not limited by the capacity of the queue, and is
+     * not subject to the overflow policy, so this never blocks or drops
+     * anything. It is meant for occasional items that can't be lost, like
+     * notifications that must stay in order with the data around them.
+     * @param val The value to add to the queue.
+     * @throw queue_closed if the queue is closed.
+     */
+    void force_put(value_type val) {
+        guard g{lock_};
+        if (closed_) throw queue_closed{};
+
+        auto nBytes = item_bytes(val);
+        push_item(std::move(val), nBytes);
     }
     /**
      * Non-blocking attempt to place an item into the queue.
@@ -233,11 +925,11 @@ public:
      */
     bool try_put(value_type val) {
         guard g{lock_};
-        if (que_.size() >= cap_ || closed_)
+        auto nBytes = item_bytes(val);
+        if (!has_room(nBytes) || closed_)
             return false;
 
-        que_.emplace(std::move(val));
-        notEmptyCond_.notify_one();
+        push_item(std::move(val), nBytes);
         return true;
     }
     /**
@@ -252,15 +944,16 @@ public:
     template <typename Rep, class Period>
     bool try_put_for(value_type val, const std::chrono::duration<Rep, Period>& relTime) {
         unique_guard g{lock_};
+        auto nBytes = item_bytes(val);
+        wait_timer timer{stats_on() && !has_room(nBytes), putBlockedNs_};
         bool to = !notFullCond_.wait_for(
 			g, relTime,
-			[this] { return que_.size() < cap_ || closed_; }
+			[this, nBytes] { return has_room(nBytes) || closed_; }
 	    );
         if (to || closed_)
             return false;
 
-        que_.emplace(std::move(val));
-        notEmptyCond_.notify_one();
+        push_item(std::move(val), nBytes);
         return true;
     }
     /**
@@ -278,16 +971,17 @@ public:
         value_type val, const std::chrono::time_point<Clock, Duration>& absTime
     ) {
         unique_guard g{lock_};
+        auto nBytes = item_bytes(val);
+        wait_timer timer{stats_on() && !has_room(nBytes), putBlockedNs_};
         bool to = !notFullCond_.wait_until(
 			g, absTime,
-			[this] { return que_.size() < cap_ || closed_; }
+			[this, nBytes] { return has_room(nBytes) || closed_; }
 	    );
 
         if (to || closed_)
             return false;
 
-        que_.emplace(std::move(val));
-        notEmptyCond_.notify_one();
+        push_item(std::move(val), nBytes);
         return true;
     }
     /**
@@ -300,14 +994,14 @@ public:
         if (!val)
             return false;
 
+        wait_timer timer{stats_on() && nItems_.load() == 0, getWaitNs_};
+        spin_not_empty();
         unique_guard g{lock_};
-        notEmptyCond_.wait(g, [this] { return !que_.empty() || closed_; });
-        if (que_.empty())  // We must be done
+        notEmptyCond_.wait(g, [this] { return has_items() || closed_; });
+        if (!has_items())  // We must be done
             return false;
 
-        *val = std::move(que_.front());
-        que_.pop();
-        notFullCond_.notify_one();
+        *val = pop_next();
         return true;
     }
     /**
@@ -317,15 +1011,14 @@ public:
      * @return The value removed from the queue
      */
     value_type get() {
+        wait_timer timer{stats_on() && nItems_.load() == 0, getWaitNs_};
+        spin_not_empty();
         unique_guard g{lock_};
-        notEmptyCond_.wait(g, [this] { return !que_.empty() || closed_; });
-        if (que_.empty())  // We must be done
+        notEmptyCond_.wait(g, [this] { return has_items() || closed_; });
+        if (!has_items())  // We must be done
             throw queue_closed{};
 
-        value_type val = std::move(que_.front());
-        que_.pop();
-        notFullCond_.notify_one();
-        return val;
+        return pop_next();
     }
     /**
      * Attempts to remove a value from the queue without blocking.
@@ -340,12 +1033,10 @@ public:
             return false;
 
         guard g{lock_};
-        if (que_.empty())
+        if (!has_items())
             return false;
 
-        *val = std::move(que_.front());
-        que_.pop();
-        notFullCond_.notify_one();
+        *val = pop_next();
         return true;
     }
     /**
@@ -364,17 +1055,16 @@ public:
             return false;
 
         unique_guard g{lock_};
+        wait_timer timer{stats_on() && !has_items(), getWaitNs_};
         notEmptyCond_.wait_for(
 			g, relTime,
-			[this] { return !que_.empty() || closed_; }
+			[this] { return has_items() || closed_; }
 	    );
 
-        if (que_.empty())
+        if (!has_items())
             return false;
 
-        *val = std::move(que_.front());
-        que_.pop();
-        notFullCond_.notify_one();
+        *val = pop_next();
         return true;
     }
     /**
@@ -395,17 +1085,97 @@ public:
             return false;
 
         unique_guard g{lock_};
+        wait_timer timer{stats_on() && !has_items(), getWaitNs_};
         notEmptyCond_.wait_until(
-			g, absTime, [this] { return !que_.empty() || closed_; }
+			g, absTime, [this] { return has_items() || closed_; }
 	    );
-        if (que_.empty())
+        if (!has_items())
             return false;
 
-        *val = std::move(que_.front());
-        que_.pop();
-        notFullCond_.notify_one();
+        *val = pop_next();
         return true;
     }
+    /**
+     * Retrieve a batch of values from the queue.
+     * If the queue is empty, this will block indefinitely until a value is
+     * added to the queue by another thread. Then it moves as many items as
+     * are available, up to the requested number, with a single
+     * acquisition of the lock.
+     * @par
+     * The items are appended to the back of the vector. An application
+     * that reserves enough space in the vector ahead of time can drain the
+     * queue without any memory allocation.
+     * @param vec The vector to receive the values.
+     * @param n The maximum number of values to retrieve.
+     * @return The number of values retrieved. This is only zero if the
+     *  	   queue is closed and empty, or if @em n is zero.
+     */
+    size_type get_n(std::vector<value_type>& vec, size_type n) {
+        if (n == 0)
+            return 0;
+
+        wait_timer timer{stats_on() && nItems_.load() == 0, getWaitNs_};
+        spin_not_empty();
+        unique_guard g{lock_};
+        notEmptyCond_.wait(g, [this] { return has_items() || closed_; });
+        return move_n(vec, n);
+    }
+    /**
+     * Attempts to remove a batch of values from the queue without
+     * blocking.
+     * This moves as many items as are available, up to the requested
+     * number, with a single acquisition of the lock.
+     * @param vec The vector to receive the values.
+     * @param n The maximum number of values to retrieve.
+     * @return The number of values retrieved, which is zero if the queue
+     *  	   is empty.
+     */
+    size_type try_get_n(std::vector<value_type>& vec, size_type n) {
+        guard g{lock_};
+        return move_n(vec, n);
+    }
+    /**
+     * Attempt to remove a batch of values from the queue, waiting a
+     * bounded amount of time for the first one to arrive.
+     * @param vec The vector to receive the values.
+     * @param n The maximum number of values to retrieve.
+     * @param relTime The amount of time to wait until timing out.
+     * @return The number of values retrieved, which is zero on timeout.
+     */
+    template <typename Rep, class Period>
+    size_type try_get_n_for(
+        std::vector<value_type>& vec, size_type n,
+        const std::chrono::duration<Rep, Period>& relTime
+    ) {
+        if (n == 0)
+            return 0;
+
+        unique_guard g{lock_};
+        wait_timer timer{stats_on() && !has_items(), getWaitNs_};
+        notEmptyCond_.wait_for(g, relTime, [this] { return has_items() || closed_; });
+        return move_n(vec, n);
+    }
+    /**
+     * Attempt to remove a batch of values from the queue, waiting until
+     * an absolute time for the first one to arrive.
+     * @param vec The vector to receive the values.
+     * @param n The maximum number of values to retrieve.
+     * @param absTime The absolute time to wait to before timing out.
+     * @return The number of values retrieved, which is zero on timeout.
+     */
+    template <class Clock, class Duration>
+    size_type try_get_n_until(
+        std::vector<value_type>& vec, size_type n,
+        const std::chrono::time_point<Clock, Duration>& absTime
+    ) {
+        if (n == 0)
+            return 0;
+
+        unique_guard g{lock_};
+        wait_timer timer{stats_on() && !has_items(), getWaitNs_};
+        notEmptyCond_.wait_until(g, absTime, [this] { return has_items() || closed_; });
+        return move_n(vec, n);
+    }
 };
 
 /////////////////////////////////////////////////////////////////////////////
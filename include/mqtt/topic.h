@@ -24,12 +24,18 @@
 #ifndef __mqtt_topic_h
 #define __mqtt_topic_h
 
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string_view>
 #include <vector>
 
 #include "MQTTAsync.h"
 #include "mqtt/delivery_token.h"
 #include "mqtt/message.h"
 #include "mqtt/subscribe_options.h"
+#include "mqtt/topic_intern_table.h"
+#include "mqtt/topic_template.h"
 #include "mqtt/types.h"
 
 namespace mqtt {
@@ -38,19 +44,150 @@ class iasync_client;
 
 /////////////////////////////////////////////////////////////////////////////
 
+/**
+ * A lazy split of a topic or filter string into its fields.
+ *
+ * This gives the same fields as @ref topic::split(), but as views into the
+ * string, found one at a time while iterating, so it does not allocate any
+ * memory. The string must outlive the object and its iterators.
+ *
+ * @code
+ * for (auto field : topic_fields{msg->get_topic()})
+ *     std::cout << field << std::endl;
+ * @endcode
+ */
+class topic_fields
+{
+    /** The topic string */
+    std::string_view str_;
+
+public:
+    /**
+     * Forward iterator over the fields.
+     */
+    class const_iterator
+    {
+        /** The topic string */
+        std::string_view str_;
+        /** The position of the current field, or npos at the end */
+        size_t pos_{std::string_view::npos};
+        /** The length of the current field */
+        size_t len_{0};
+
+        friend class topic_fields;
+
+        const_iterator(std::string_view str) : str_{str}, pos_{0} { find_end(); }
+
+        /** Finds the end of the field at the current position */
+        void find_end() {
+            auto sep = str_.find('/', pos_);
+            len_ = (sep == std::string_view::npos) ? str_.size() - pos_ : sep - pos_;
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = std::string_view;
+
+        /**
+         * Creates an end iterator.
+         */
+        const_iterator() = default;
+        /**
+         * Gets the current field.
+         * @return A view of the current field.
+         */
+        std::string_view operator*() const { return str_.substr(pos_, len_); }
+        /**
+         * Moves to the next field.
+         * @return A reference to this iterator.
+         */
+        const_iterator& operator++() {
+            pos_ += len_ + 1;
+            if (pos_ > str_.size())
+                pos_ = std::string_view::npos;
+            else
+                find_end();
+            return *this;
+        }
+        /**
+         * Moves to the next field.
+         * @return A copy of the iterator before it was moved.
+         */
+        const_iterator operator++(int) {
+            auto tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+        /**
+         * Determines if two iterators point to the same field.
+         * Only iterators over the same string can be compared.
+         */
+        bool operator==(const const_iterator& other) const { return pos_ == other.pos_; }
+        /**
+         * Determines if two iterators point to different fields.
+         * Only iterators over the same string can be compared.
+         */
+        bool operator!=(const const_iterator& other) const { return pos_ != other.pos_; }
+    };
+
+    /**
+     * Creates a split of the topic string.
+     * @param str The topic or filter string.
+     */
+    explicit topic_fields(std::string_view str) : str_{str} {}
+    /**
+     * Determines if there are no fields, which is only the case for an
+     * empty string.
+     * @return @em true if there are no fields, @em false otherwise.
+     */
+    bool empty() const { return str_.empty(); }
+    /**
+     * Gets an iterator to the first field.
+     * @return An iterator to the first field.
+     */
+    const_iterator begin() const { return str_.empty() ? end() : const_iterator{str_}; }
+    /**
+     * Gets an iterator past the last field.
+     * @return An iterator past the last field.
+     */
+    const_iterator end() const { return const_iterator{}; }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
 /**
  * Represents a topic destination, used for publish/subscribe messaging.
+ *
+ * A topic can also be made from a @ref topic_template, to publish on a
+ * family of topics, like "site/{}/sensor/{}", with the field values given
+ * for each message by @ref publish_fields(). The names are formatted into
+ * a buffer kept by the topic, and the recent ones are kept as shared
+ * strings, so that publishing to them again doesn't allocate a new topic
+ * string for each message. Publishing with fields is not thread-safe; each
+ * thread should have its own topic object.
  */
 class topic
 {
     /** The client to which this topic is connected */
     iasync_client& cli_;
-    /** The topic name */
+    /** The topic name, or the pattern if the topic has a template */
     string name_;
     /** The default QoS */
     int qos_;
     /** The default retained flag */
     bool retained_;
+    /** The template for the names. This refers to the name string. */
+    topic_template tmpl_;
+    /** Buffer to format the names from the template */
+    string buf_;
+    /** The recent names made from the template (if any) */
+    std::unique_ptr<topic_intern_table> names_;
+
+    /** Publishes a message on a topic name made from the template */
+    delivery_token_ptr publish_name(string_ref name, binary_ref payload);
 
 public:
     /** A smart/shared pointer to this class. */
@@ -70,6 +207,42 @@ public:
         bool retained = message::DFLT_RETAINED
     )
         : cli_(cli), name_(name), qos_(qos), retained_(retained) {}
+    /**
+     * Construct an MQTT topic destination for messages, with names made
+     * from a template.
+     * @param cli Client to which the topic is attached
+     * @param tmpl The template for the topic names. The topic keeps its
+     *  		   own copy of the pattern.
+     * @param qos The default QoS for publishing.
+     * @param retained The default retained flag for the topic.
+     * @param nNames The number of recent names to keep as shared strings.
+     */
+    topic(
+        iasync_client& cli, const topic_template& tmpl, int qos = message::DFLT_QOS,
+        bool retained = message::DFLT_RETAINED,
+        size_t nNames = topic_intern_table::DFLT_CAPACITY
+    )
+        : cli_(cli),
+          name_(tmpl.pattern()),
+          qos_(qos),
+          retained_(retained),
+          tmpl_{std::string_view{name_}},
+          names_{std::make_unique<topic_intern_table>(nNames)} {}
+    /**
+     * Copies a topic.
+     * A copy of a topic with a template starts without any recent names.
+     * @param other The topic to copy.
+     */
+    topic(const topic& other)
+        : cli_(other.cli_),
+          name_(other.name_),
+          qos_(other.qos_),
+          retained_(other.retained_),
+          tmpl_{other.names_ ? topic_template{std::string_view{name_}} : topic_template{}},
+          names_{
+              other.names_ ? std::make_unique<topic_intern_table>(other.names_->capacity())
+                           : nullptr
+          } {}
     /**
      * Creates a new topic
      * @param cli Client to which the topic is attached
@@ -97,10 +270,40 @@ public:
     /**
      * Splits a topic string into individual fields.
      *
+     * This copies each field into a new string. Use @ref split_view() to
+     * split a topic without allocating any memory.
+     *
      * @param topic A slash-delimited MQTT topic string.
      * @return A vector containing the fields of the topic.
      */
     static std::vector<std::string> split(const std::string& topic);
+    /**
+     * Splits a topic string into individual fields, lazily, as views into
+     * the string.
+     *
+     * @param topic A slash-delimited MQTT topic string. This must outlive
+     *  			the result.
+     * @return A range of the fields of the topic.
+     */
+    static topic_fields split_view(std::string_view topic) { return topic_fields{topic}; }
+    /**
+     * Determines if a string is a valid topic name for publishing.
+     *
+     * A topic name must not be empty or contain wildcards, '+' or '#', or
+     * NUL characters, must be valid UTF-8, and must be no longer than 65535
+     * bytes.
+     *
+     * @param name The topic name.
+     * @return @em true if the name is valid, @em false otherwise.
+     */
+    static bool is_valid_name(std::string_view name);
+    /**
+     * Checks that a string is a valid topic name for publishing.
+     * @param name The topic name.
+     * @throw exception with the reason code TOPIC_NAME_INVALID if the
+     *  	  name is not valid, as described for @ref is_valid_name().
+     */
+    static void validate_name(std::string_view name);
     /**
      * Gets the default quality of service for this topic.
      * @return The default quality of service for this topic.
@@ -164,6 +367,40 @@ public:
      *  	   complete.
      */
     delivery_token_ptr publish(binary_ref payload, int qos, bool retained);
+    /**
+     * Determines if the topic names are made from a template.
+     * @return @em true if the topic has a template, @em false if it has a
+     *  	   single name.
+     */
+    bool has_template() const { return bool(names_); }
+    /**
+     * Gets the template for the topic names.
+     * @return The template. This is empty if the topic has a single name.
+     */
+    const topic_template& get_template() const { return tmpl_; }
+    /**
+     * Publishes a message on the topic made from the template and field
+     * values, using the default QoS and retained flag.
+     * A topic without a template has no fields, so it can only be used
+     * without any values.
+     * @param payload the bytes to use as the message payload
+     * @param vals The values for the fields of the template. These can be
+     *  		   integers, or anything that converts to a string view.
+     * @return The delivery token used to track and wait for the publish to
+     *  	   complete.
+     * @throw std::invalid_argument if the number of values doesn't match
+     *  	  the number of fields in the template.
+     */
+    template <typename... Args>
+    delivery_token_ptr publish_fields(binary_ref payload, const Args&... vals) {
+        if (!names_) {
+            if (sizeof...(Args) != 0)
+                throw std::invalid_argument{"topic has no template fields"};
+            return publish(std::move(payload));
+        }
+        tmpl_.format_to(buf_, vals...);
+        return publish_name(names_->intern(buf_), std::move(payload));
+    }
     /**
      * Subscribe to the topic.
      * @return A token used to track the progress of the operation.
@@ -182,6 +419,102 @@ using topic_ptr = topic::ptr_t;
 /** A smart/shared pointer to a const topic object. */
 using const_topic_ptr = topic::const_ptr_t;
 
+/////////////////////////////////////////////////////////////////////////////
+//  						Topic Captures
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The parts of a topic that matched the wildcards of a topic filter.
+ *
+ * For the topic "site/42/line/7/temp/max", and the filter
+ * "site/+/line/+/temp/#", these are the fields "42" and "7" that matched
+ * the single-field wildcards, '+', and the tail "max" that matched the
+ * multi-field wildcard, '#'.
+ * @par
+ * The captures are views into the topic string, which must outlive them.
+ * They are kept inside the object, so capturing them does not allocate any
+ * memory.
+ */
+class topic_captures
+{
+public:
+    /** The most single-field wildcards that can be captured */
+    static constexpr size_t MAX_CAPTURES = 16;
+
+private:
+    /** The fields that matched the '+' wildcards */
+    std::string_view fields_[MAX_CAPTURES];
+    /** The number of fields */
+    size_t n_{0};
+    /** The fields that matched the '#' wildcard */
+    std::string_view tail_;
+    /** Whether the filter ended in a '#' wildcard */
+    bool hasTail_{false};
+
+    friend class topic_filter;
+
+    /** Adds a field that matched a '+' wildcard */
+    void push(std::string_view field);
+    /** Sets the fields that matched a '#' wildcard */
+    void set_tail(std::string_view tail) {
+        tail_ = tail;
+        hasTail_ = true;
+    }
+
+public:
+    /**
+     * Creates an empty set of captures.
+     */
+    topic_captures() = default;
+    /**
+     * Gets the captures for a topic that is known to match a filter.
+     * @param filter The topic filter. This can be a shared subscription
+     *  			 filter.
+     * @param topic The topic that matched the filter.
+     * @throw std::length_error if the filter has more than @ref
+     *  	  MAX_CAPTURES single-field wildcards.
+     */
+    topic_captures(std::string_view filter, std::string_view topic);
+    /**
+     * Gets the number of fields that matched single-field wildcards.
+     * @return The number of fields that matched single-field wildcards.
+     */
+    size_t size() const { return n_; }
+    /**
+     * Determines if there are no captures.
+     * @return @em true if nothing matched a wildcard, @em false otherwise.
+     */
+    bool empty() const { return n_ == 0 && !hasTail_; }
+    /**
+     * Gets a field that matched a single-field wildcard.
+     * @param i The index of the wildcard in the filter.
+     * @return The field of the topic that matched it.
+     */
+    std::string_view operator[](size_t i) const { return fields_[i]; }
+    /**
+     * Determines if the filter ended in a multi-field wildcard.
+     * @return @em true if the filter ended in a '#' wildcard, @em false
+     *  	   otherwise.
+     */
+    bool has_tail() const { return hasTail_; }
+    /**
+     * Gets the fields that matched the multi-field wildcard, '#'.
+     * @return The rest of the topic that matched the '#', without a leading
+     *  	   separator. This is empty if the filter doesn't end in a '#'.
+     */
+    std::string_view tail() const { return tail_; }
+    /**
+     * Gets an iterator to the fields that matched single-field wildcards.
+     * @return An iterator to the first captured field.
+     */
+    const std::string_view* begin() const { return fields_; }
+    /**
+     * Gets an iterator past the fields that matched single-field wildcards.
+     * @return An iterator past the last captured field.
+     */
+    const std::string_view* end() const { return fields_ + n_; }
+};
+
 /////////////////////////////////////////////////////////////////////////////
 //  						Topic Filter
 /////////////////////////////////////////////////////////////////////////////
@@ -196,11 +529,19 @@ using const_topic_ptr = topic::const_ptr_t;
  *     '#' - Matches all subsequent fields (must be last field in filter)
  *
  * It can be used to match against specific topics.
+ *
+ * An MQTT v5 shared subscription filter, "$share/{group}/{filter}",
+ * matches the same topics as the filter after the group name.
  */
 class topic_filter
 {
     /** We store the filter as a vector of the individual fields.  */
     std::vector<string> fields_;
+    /** The group name, if this is a shared subscription */
+    string group_;
+
+    /** Matches a topic, capturing the wildcard fields if requested */
+    bool match(std::string_view topic, topic_captures* caps) const;
 
 public:
     /**
@@ -242,14 +583,68 @@ public:
      *  	   if not.
      */
     bool has_wildcards() const;
+    /**
+     * Determines if the filter is for a shared subscription.
+     * This is a filter in the form "$share/{group}/{filter}", where the
+     * group name is not empty and has no wildcards, and is followed by a
+     * non-empty filter.
+     * @param filter The topic filter string.
+     * @return @em true if the filter is for a shared subscription, @em
+     *  	   false otherwise.
+     */
+    static bool is_shared(const string& filter);
+    /**
+     * Determines if this is a filter for a shared subscription.
+     * @return @em true if this is for a shared subscription, @em false
+     *  	   otherwise.
+     */
+    bool is_shared() const { return !group_.empty(); }
+    /**
+     * Gets the group name of a shared subscription filter.
+     * @param filter The topic filter string.
+     * @return The group name, or an empty string if this is not a shared
+     *  	   subscription filter.
+     */
+    static string share_group(const string& filter);
+    /**
+     * Gets the group name, if this is for a shared subscription.
+     * @return The group name, or an empty string if this is not a shared
+     *  	   subscription filter.
+     */
+    const string& share_group() const { return group_; }
+    /**
+     * Gets the filter for matching topics, removing the prefix of a shared
+     * subscription, if any.
+     * @param filter The topic filter string.
+     * @return The filter after the group name of a shared subscription,
+     *  	   otherwise the filter, unchanged.
+     */
+    static string strip_share(const string& filter);
     /**
      * Determine if the topic matches this filter.
      *
+     * This walks the topic in place, and does not allocate any memory.
+     *
      * @param topic An MQTT topic. It should not contain wildcards.
      * @return  @em true of the topic matches this filter, @em false
      *  		otherwise.
      */
-    bool matches(const string& topic) const;
+    bool matches(std::string_view topic) const { return match(topic, nullptr); }
+    /**
+     * Determine if the topic matches this filter, and if so, gets the
+     * parts of it that matched the wildcards.
+     *
+     * @param topic An MQTT topic. It should not contain wildcards.
+     * @param caps Gets the captures, as views into the topic, if it
+     *  		   matches.
+     * @return  @em true of the topic matches this filter, @em false
+     *  		otherwise.
+     * @throw std::length_error if the filter has more than
+     *  	  topic_captures::MAX_CAPTURES single-field wildcards.
+     */
+    bool matches(std::string_view topic, topic_captures& caps) const {
+        return match(topic, &caps);
+    }
 };
 
 /////////////////////////////////////////////////////////////////////////////
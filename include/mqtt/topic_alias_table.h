@@ -0,0 +1,137 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file topic_alias_table.h
+/// Declaration of MQTT topic_alias_table class
+/// @date 16-Oct-2026
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_topic_alias_table_h
+#define __mqtt_topic_alias_table_h
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+#include "mqtt/clock_index.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The MQTT v5 topic aliases that a client has assigned to the topics that
+ * it publishes on a connection.
+ *
+ * A topic alias is a number from one up to the maximum allowed by the
+ * receiver. The first message published on a topic carries the full topic
+ * name along with the alias, and after that, messages can be sent with an
+ * empty topic and only the alias, saving the bytes of the topic name.
+ * @par
+ * The table holds up to a fixed number of aliases. When it is full, the
+ * alias of a topic that wasn't used recently is taken, as picked by a
+ * @ref clock_index. The next message on the new topic then carries the
+ * full name, which remaps the alias on the receiver.
+ * @par
+ * The aliases only last for the life of a network connection, so the table
+ * must be reset each time the client connects.
+ * @par
+ * The table is not thread-safe. Access to it must be serialized, in the
+ * same order that the messages are sent.
+ */
+class topic_alias_table
+{
+public:
+    /** The largest number of aliases allowed by MQTT v5 */
+    static constexpr uint16_t MAX_ALIASES = 65535;
+
+private:
+    /** The topics. The alias of each one is its slot number, plus one. */
+    clock_index<string> topics_;
+
+public:
+    /**
+     * Creates a table.
+     * @param maxAliases The maximum number of aliases. Zero disables the
+     *  				 aliases.
+     */
+    explicit topic_alias_table(uint16_t maxAliases = 0) { reset(maxAliases); }
+    /**
+     * The table can't be copied, since the index refers to its own topics.
+     */
+    topic_alias_table(const topic_alias_table&) = delete;
+    /**
+     * The table can't be copied.
+     */
+    topic_alias_table& operator=(const topic_alias_table&) = delete;
+    /**
+     * Gets the maximum number of aliases.
+     * @return The maximum number of aliases.
+     */
+    uint16_t capacity() const { return uint16_t(topics_.capacity()); }
+    /**
+     * Gets the number of topics that have aliases.
+     * @return The number of topics that have aliases.
+     */
+    size_t size() const { return topics_.size(); }
+    /**
+     * Determines if aliases can be assigned.
+     * @return @em true if the table has room for any aliases, @em false if
+     *  	   aliases are disabled.
+     */
+    bool enabled() const { return topics_.capacity() != 0; }
+    /**
+     * Removes all the aliases and sets the maximum number of them.
+     * This should be called with the maximum allowed by the receiver each
+     * time the client connects.
+     * @param maxAliases The maximum number of aliases. Zero disables the
+     *  				 aliases.
+     */
+    void reset(uint16_t maxAliases) { topics_.reset(maxAliases); }
+    /**
+     * Gets the alias for a topic, if it has one.
+     * This doesn't count as a use of the alias.
+     * @param topic The topic name.
+     * @return The alias, or zero if the topic doesn't have one.
+     */
+    uint16_t find(std::string_view topic) const;
+    /**
+     * Gets the alias to send a message on a topic, assigning one if needed.
+     * If the topic is new, and the table is full, the alias is taken from
+     * a topic that wasn't used recently.
+     * @param topic The topic name. This must not be empty.
+     * @return A pair of the alias and a flag that is @em true if the alias
+     *  	   was just assigned, in which case the message must be sent
+     *  	   with the full topic name. The alias is zero if aliases are
+     *  	   disabled.
+     */
+    std::pair<uint16_t, bool> assign(const string& topic);
+    /**
+     * Removes the alias for a topic.
+     * This is used when a message that was to assign an alias couldn't be
+     * sent.
+     * @param topic The topic name.
+     * @return @em true if the topic had an alias, @em false otherwise.
+     */
+    bool remove(std::string_view topic) { return topics_.erase(topic); }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_topic_alias_table_h
@@ -0,0 +1,154 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file topic_intern_table.h
+/// Declaration of MQTT topic_intern_table class
+/// @date 16-Oct-2026
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_topic_intern_table_h
+#define __mqtt_topic_intern_table_h
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "mqtt/buffer_ref.h"
+#include "mqtt/clock_index.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A bounded table of the topics of incoming messages, which hands out a
+ * shared, immutable, string for each one, and resolves MQTT v5 topic
+ * aliases.
+ *
+ * Messages that arrive on the same topic can then share one topic buffer,
+ * rather than each one allocating its own. Since the buffer is shared, the
+ * topics of two messages can be compared by the pointers in their topic
+ * references before comparing the strings.
+ * @par
+ * The table holds up to a fixed number of topics, and when it is full,
+ * replaces one that wasn't used recently, as picked by a @ref clock_index.
+ * An evicted topic stays valid for as long as any message refers to it.
+ * @par
+ * The topic aliases sent by the server are kept separately, and aren't
+ * bound by the capacity, since the server decides how many it uses, up to
+ * the maximum that the client allowed when it connected. The aliases only
+ * last for a single connection, so they must be cleared each time the
+ * client connects.
+ * @par
+ * The table is not thread-safe. It should only be used by the thread that
+ * delivers the incoming messages.
+ */
+class topic_intern_table
+{
+    /** The shared topics */
+    clock_index<string_ref> topics_;
+    /** The topics for the aliases, indexed by alias */
+    std::vector<string_ref> aliases_;
+    /** The number of topics that were found in the table */
+    size_t nHit_{0};
+    /** The number of topics that had to be added to the table */
+    size_t nMiss_{0};
+
+public:
+    /** The default number of topics in the table */
+    static constexpr size_t DFLT_CAPACITY = 1024;
+
+    /**
+     * Creates a table.
+     * @param capacity The maximum number of topics to keep in the table.
+     * @throw std::invalid_argument if the capacity is zero.
+     */
+    explicit topic_intern_table(size_t capacity = DFLT_CAPACITY);
+    /**
+     * The table can't be copied, since the index refers to its own
+     * topics.
+     */
+    topic_intern_table(const topic_intern_table&) = delete;
+    /**
+     * The table can't be copied.
+     */
+    topic_intern_table& operator=(const topic_intern_table&) = delete;
+    /**
+     * Gets the maximum number of topics in the table.
+     * @return The maximum number of topics in the table.
+     */
+    size_t capacity() const { return topics_.capacity(); }
+    /**
+     * Gets the number of topics in the table.
+     * @return The number of topics in the table.
+     */
+    size_t size() const { return topics_.size(); }
+    /**
+     * Gets the number of topics that were already in the table.
+     * @return The number of table hits.
+     */
+    size_t hits() const { return nHit_; }
+    /**
+     * Gets the number of topics that had to be added to the table.
+     * @return The number of table misses.
+     */
+    size_t misses() const { return nMiss_; }
+    /**
+     * Gets the shared string for a topic, adding it to the table if it's
+     * not already there.
+     * @param topic The topic name.
+     * @return A reference to the shared topic string.
+     */
+    string_ref intern(std::string_view topic);
+    /**
+     * Gets the shared string for the topic of an incoming message, taking
+     * any topic alias into account.
+     * If the message has a topic name and an alias, the alias is mapped to
+     * the topic. If it only has an alias, the topic is the one that was
+     * last mapped to the alias.
+     * @param topic The topic name from the message, which may be empty.
+     * @param alias The topic alias from the message, or zero if none.
+     * @return A reference to the shared topic string. This is a null
+     *  	   reference if the message only had an alias, and it wasn't
+     *  	   mapped to a topic.
+     */
+    string_ref resolve(std::string_view topic, uint16_t alias);
+    /**
+     * Gets the topic that an alias is mapped to.
+     * @param alias The topic alias.
+     * @return A reference to the shared topic string, or a null reference
+     *  	   if the alias isn't mapped.
+     */
+    string_ref alias_topic(uint16_t alias) const {
+        return (alias < aliases_.size()) ? aliases_[alias] : string_ref{};
+    }
+    /**
+     * Removes all the topic aliases.
+     * This should be called each time the client connects.
+     */
+    void clear_aliases() { aliases_.clear(); }
+    /**
+     * Removes all the topics and aliases from the table.
+     */
+    void clear();
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_topic_intern_table_h
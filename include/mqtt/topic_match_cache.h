@@ -0,0 +1,186 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file topic_match_cache.h
+/// Declaration of MQTT topic_match_cache class
+/// @date 16-Oct-2026
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_topic_match_cache_h
+#define __mqtt_topic_match_cache_h
+
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "mqtt/clock_index.h"
+#include "mqtt/topic_matcher.h"
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A bounded cache of the results of matching topics against a
+ * @ref topic_matcher.
+ *
+ * When the same, fairly small, set of topics is matched over and over,
+ * this turns the walk of the trie for each topic into a single hash
+ * lookup. It maps each topic to the list of matching entries in the
+ * collection.
+ * @par
+ * The cache holds up to a fixed number of topics, and when it is full,
+ * drops one that wasn't used recently, as picked by a @ref clock_index.
+ * @par
+ * The cache refers to the collection, which must outlive it. Each result
+ * is stamped with the generation of the collection when it was made. If
+ * the collection changes, by inserting or removing values, any stale
+ * result is recomputed the next time its topic is matched.
+ * @par
+ * The cache is not thread-safe. Each thread should have its own, or access
+ * to a shared one must be serialized, along with any changes to the
+ * collection.
+ *
+ * @code
+ * topic_matcher<handler> handlers;
+ * topic_match_cache<handler> cache{handlers, 8192};
+ * ...
+ * for (const auto* val : cache.matches(msg->get_topic()))
+ *     val->second(msg);
+ * @endcode
+ */
+template <typename T>
+class topic_match_cache
+{
+public:
+    /** The type of collection being cached */
+    using matcher_type = topic_matcher<T>;
+    /** The type of values in the collection */
+    using value_type = typename matcher_type::value_type;
+    /** The result of a match: pointers to the matching values */
+    using result_type = std::vector<const value_type*>;
+
+private:
+    /** The result for a topic in the cache */
+    struct entry
+    {
+        /** The matching values */
+        result_type result;
+        /** The generation of the collection for the result */
+        uint64_t gen{0};
+    };
+
+    /** The collection */
+    const matcher_type& tm_;
+    /** The topics in the cache */
+    clock_index<string> topics_;
+    /** The results, by the slot of their topic */
+    std::vector<entry> entries_;
+    /** The number of lookups that found a valid result */
+    size_t nHit_{0};
+    /** The number of lookups that had to match the topic */
+    size_t nMiss_{0};
+
+    /** Matches the topic in a slot against the collection */
+    const result_type& fill(size_t i) {
+        if (i == entries_.size())
+            entries_.emplace_back();
+
+        auto& ent = entries_[i];
+        ent.result.clear();
+        auto end = tm_.matches_cend();
+        for (auto it = tm_.matches(std::string_view{topics_.key(i)}); it != end; ++it)
+            ent.result.push_back(&*it);
+        ent.gen = tm_.generation();
+        return ent.result;
+    }
+
+public:
+    /**
+     * Creates a cache for a topic matcher.
+     * @param tm The collection. This must outlive the cache.
+     * @param capacity The maximum number of topics to keep in the cache.
+     * @throw std::invalid_argument if the capacity is zero.
+     */
+    topic_match_cache(const matcher_type& tm, size_t capacity) : tm_{tm}, topics_{capacity} {
+        if (capacity == 0)
+            throw std::invalid_argument{"cache capacity must be non-zero"};
+    }
+    /**
+     * The cache can't be copied, since the index refers to its own
+     * topics.
+     */
+    topic_match_cache(const topic_match_cache&) = delete;
+    /**
+     * The cache can't be copied.
+     */
+    topic_match_cache& operator=(const topic_match_cache&) = delete;
+    /**
+     * Gets the maximum number of topics in the cache.
+     * @return The maximum number of topics in the cache.
+     */
+    size_t capacity() const { return topics_.capacity(); }
+    /**
+     * Gets the number of topics in the cache.
+     * @return The number of topics in the cache.
+     */
+    size_t size() const { return topics_.size(); }
+    /**
+     * Gets the number of lookups that were answered from the cache.
+     * @return The number of cache hits.
+     */
+    size_t hits() const { return nHit_; }
+    /**
+     * Gets the number of lookups that had to search the collection, either
+     * because the topic was not in the cache, or the result was stale.
+     * @return The number of cache misses.
+     */
+    size_t misses() const { return nMiss_; }
+    /**
+     * Removes all the topics from the cache.
+     */
+    void clear() {
+        topics_.clear();
+        entries_.clear();
+    }
+    /**
+     * Gets the values in the collection that match the topic.
+     * @param topic The topic to search for matches.
+     * @return A reference to the matching values, in no particular order.
+     *  	   This is valid until the next call to `matches()` or a change
+     *  	   to the collection.
+     */
+    const result_type& matches(const string& topic) {
+        auto i = topics_.lookup(topic);
+        if (i != topics_.npos && entries_[i].gen == tm_.generation()) {
+            ++nHit_;
+            return entries_[i].result;
+        }
+
+        ++nMiss_;
+        if (i == topics_.npos)
+            i = topics_.insert(topic);
+        return fill(i);
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_topic_match_cache_h
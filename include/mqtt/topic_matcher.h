@@ -24,11 +24,16 @@
 #ifndef __mqtt_topic_matcher_h
 #define __mqtt_topic_matcher_h
 
-#include <forward_list>
+#include <algorithm>
+#include <cstdint>
+#include <exception>
 #include <initializer_list>
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "mqtt/topic.h"
@@ -65,6 +70,11 @@ namespace mqtt {
  *
  * Thus, the collection gives an iterator for the items matching a topic.
  *
+ * A shared subscription filter, like "$share/group/data/+/engine", matches
+ * the same topics as the filter after the group name. Filters for
+ * different groups are kept as separate items, so a topic matches each of
+ * them.
+ *
  * A common use for this would be to store callbacks to process incoming
  * messages based on topics.
  *
@@ -117,6 +127,9 @@ public:
     using value_ptr = std::unique_ptr<value_type>;
     using mapped_ptr = std::unique_ptr<mapped_type>;
 
+    /** A result of a batch match: the index of the topic and a matching value */
+    using batch_result = std::pair<size_t, const value_type*>;
+
 private:
     /**
      * The nodes of the collection.
@@ -124,7 +137,7 @@ private:
     struct node
     {
         using ptr_t = std::unique_ptr<node>;
-        using map_t = std::map<string, ptr_t>;
+        using map_t = std::map<string, ptr_t, std::less<>>;
 
         /** The value that matches the topic at this node, if any */
         value_ptr content;
@@ -157,6 +170,139 @@ private:
 
     /** The root node of the collection */
     node_ptr root_;
+    /** The generation of the contents, bumped on each change */
+    uint64_t gen_{0};
+
+    /** The smallest share of a batch worth handing to another thread */
+    static constexpr size_t MIN_BATCH_PER_THREAD = 1024;
+
+    /**
+     * Gets the path of the nodes for a filter.
+     *
+     * This is normally the fields of the filter. A shared subscription,
+     * "$share/{group}/{filter}", is kept at a child of the node for its
+     * filter, under a key of a slash and the group name. Since a field can't
+     * contain a slash, these never get mixed up with the filter fields.
+     */
+    static std::vector<string> key_path(const key_type& filter) {
+        if (!topic_filter::is_shared(filter))
+            return topic::split(filter);
+
+        auto fields = topic::split(topic_filter::strip_share(filter));
+        fields.push_back('/' + topic_filter::share_group(filter));
+        return fields;
+    }
+    /**
+     * Calls a function for the value of each shared subscription kept at
+     * a node.
+     */
+    template <typename Fn>
+    static void for_each_shared(const node* nd, Fn fn) {
+        auto it = nd->children.lower_bound("/");
+        for (; it != nd->children.end() && it->first[0] == '/'; ++it) {
+            if (it->second->content)
+                fn(it->second.get());
+        }
+    }
+
+    /**
+     * Matches a run of topics, which should be sorted so that topics with
+     * the same leading fields are next to each other.
+     *
+     * This walks the trie one level at a time, keeping the set of nodes
+     * reached after each field of the topic. The levels for the fields
+     * that a topic shares with the one before it are reused, so only the
+     * fields after the common prefix are searched.
+     *
+     * @param topics All the topics in the batch.
+     * @param first Points to the first index of the topics to match.
+     * @param last Points past the last index of the topics to match.
+     * @param out Vector to receive the results.
+     */
+    void match_sorted(
+        const std::vector<std::string_view>& topics, const size_t* first, const size_t* last,
+        std::vector<batch_result>& out
+    ) const {
+        // The nodes reached at each level, and the '#' values found
+        // when stepping from each level to the next.
+        std::vector<std::vector<const node*>> reached{{root_.get()}};
+        std::vector<std::vector<const value_type*>> hashes;
+        size_t nLevel = 1;
+
+        std::vector<std::string_view> fields, prevFields;
+
+        for (; first != last; ++first) {
+            auto topic = topics[*first];
+
+            fields.clear();
+            for (size_t pos = 0;;) {
+                auto sep = topic.find('/', pos);
+                fields.push_back(topic.substr(pos, sep - pos));
+                if (sep == std::string_view::npos)
+                    break;
+                pos = sep + 1;
+            }
+
+            // Keep the levels for the fields shared with the last topic
+            size_t k = 0, n = std::min(fields.size(), prevFields.size());
+            while (k < n && fields[k] == prevFields[k]) ++k;
+            nLevel = std::min(nLevel, k + 1);
+
+            while (nLevel <= fields.size() && !reached[nLevel - 1].empty()) {
+                const auto lvl = nLevel - 1;
+                const auto field = fields[lvl];
+
+                if (reached.size() <= nLevel)
+                    reached.resize(nLevel + 1);
+                if (hashes.size() <= lvl)
+                    hashes.resize(lvl + 1);
+
+                auto& nxt = reached[nLevel];
+                auto& hash = hashes[lvl];
+                nxt.clear();
+                hash.clear();
+
+                // Topics starting with '$' don't match wildcards in the first field
+                bool wild = lvl != 0 || field.empty() || field[0] != '$';
+
+                for (const auto* nd : reached[lvl]) {
+                    auto end = nd->children.end();
+                    auto child = nd->children.find(field);
+                    if (child != end)
+                        nxt.push_back(child->second.get());
+
+                    if (wild) {
+                        if ((child = nd->children.find("+")) != end)
+                            nxt.push_back(child->second.get());
+                        if ((child = nd->children.find("#")) != end) {
+                            const auto* hnd = child->second.get();
+                            if (hnd->content)
+                                hash.push_back(hnd->content.get());
+                            for_each_shared(hnd, [&](const node* shnd) {
+                                hash.push_back(shnd->content.get());
+                            });
+                        }
+                    }
+                }
+                ++nLevel;
+            }
+
+            for (size_t i = 0; i + 1 < nLevel && i < fields.size(); ++i) {
+                for (auto pval : hashes[i]) out.emplace_back(*first, pval);
+            }
+            if (nLevel == fields.size() + 1) {
+                for (const auto* nd : reached[fields.size()]) {
+                    if (nd->content)
+                        out.emplace_back(*first, nd->content.get());
+                    for_each_shared(nd, [&](const node* shnd) {
+                        out.emplace_back(*first, shnd->content.get());
+                    });
+                }
+            }
+
+            std::swap(fields, prevFields);
+        }
+    }
 
 public:
     /** Generic iterator over all items in the collection. */
@@ -270,6 +416,12 @@ public:
     /**
      * Iterator that efficiently searches the collection for topic
      * matches.
+     *
+     * Given a view of the topic, this does not allocate any memory for a
+     * typical search. The fields of the topic are kept as offsets into the
+     * topic string, and the nodes still to be searched are kept in a small
+     * stack inside the iterator, which only spills over to the heap for
+     * very deep topics.
      */
     class match_iterator
     {
@@ -278,91 +430,131 @@ public:
         {
             /** The current node being searched. */
             node* node_;
-            /** The fields of the topic still to be searched. */
-            std::forward_list<string> fields_;
+            /** The offset in the topic of the next field to search. */
+            size_t pos_;
+            /** Whether there are fields of the topic still to be searched. */
+            bool more_;
             /** Whether this is the first/root node */
             bool first_;
-
-            search_node(node* nd, const std::forward_list<string>& sy, bool first = false)
-                : node_{nd}, fields_{sy}, first_{first} {}
-            search_node(node* nd, std::forward_list<string>&& sy, bool first = false)
-                : node_{nd}, fields_{std::move(sy)}, first_{first} {}
         };
 
+        /** The number of search nodes kept inside the iterator */
+        static constexpr size_t N_STACK = 16;
+
         /** The last-found value */
         value_type* pval_;
+        /** The topic, if the iterator owns it */
+        string topicStr_;
+        /** The topic, if owned by the caller */
+        std::string_view topicView_;
+        /** Whether the iterator owns the topic string */
+        bool ownsTopic_{false};
         /** The nodes still to be checked, used as a stack */
-        std::vector<search_node> nodes_;
+        search_node stack_[N_STACK]{};
+        /** The number of nodes in the stack */
+        size_t nStack_{0};
+        /** The nodes that didn't fit in the stack */
+        std::vector<search_node> overflow_;
+
+        /** Gets the topic being matched */
+        std::string_view topic() const noexcept {
+            return ownsTopic_ ? std::string_view{topicStr_} : topicView_;
+        }
+        /** Pushes a node onto the search stack */
+        void push(node* nd, size_t pos, bool more, bool first = false) {
+            if (nStack_ < N_STACK)
+                stack_[nStack_++] = search_node{nd, pos, more, first};
+            else
+                overflow_.push_back(search_node{nd, pos, more, first});
+        }
+        /** Pops the next node off the search stack, if any. */
+        bool pop(search_node& snode) noexcept {
+            if (!overflow_.empty()) {
+                snode = overflow_.back();
+                overflow_.pop_back();
+            }
+            else if (nStack_ > 0) {
+                snode = stack_[--nStack_];
+            }
+            else {
+                return false;
+            }
+            return true;
+        }
+        /** Starts the search at the root node */
+        void start(node* root) {
+            push(root, 0, true, true);
+            next();
+        }
 
         /**
          * Move the next iterator to the next value, or to end(), if none
          * left.
          *
-         * This will keep recursing until it finds a matching node that
+         * This will keep searching until it finds a matching node that
          * contains a value or it reaches the end.
          */
         void next() {
             pval_ = nullptr;
+            search_node snode;
+
+            while (pop(snode)) {
+                // If we're at the end of the topic fields, we either have a value,
+                // or need to move on to the next node to search.
+                if (!snode.more_) {
+                    for_each_shared(snode.node_, [this](const node* shnd) {
+                        push(const_cast<node*>(shnd), 0, false);
+                    });
+                    if ((pval_ = snode.node_->content.get()) != nullptr)
+                        return;
+                    continue;
+                }
 
-            // If there are no nodes left to search, we're done.
-            if (nodes_.empty())
-                return;
-
-            // Get the next node to search.
-            auto snode = std::move(nodes_.back());
-            nodes_.pop_back();
-
-            // If we're at the end of the topic fields, we either have a value,
-            // or need to move on to the next node to search.
-            if (snode.fields_.empty()) {
-                pval_ = snode.node_->content.get();
-                if (!pval_)
-                    this->next();
-                return;
-            }
-
-            // Get the next field of the topic to search
-            auto field = std::move(snode.fields_.front());
-            snode.fields_.pop_front();
-
-            typename node_map::iterator child;
-            const auto map_end = snode.node_->children.end();
-
-            // Look for an exact match
-            if ((child = snode.node_->children.find(field)) != map_end) {
-                nodes_.push_back({child->second.get(), snode.fields_});
-            }
+                // Get the next field of the topic to search
+                auto top = topic();
+                auto sep = top.find('/', snode.pos_);
+                bool more = (sep != std::string_view::npos);
+                auto field = top.substr(snode.pos_, more ? sep - snode.pos_ : top.npos);
+                auto pos = more ? sep + 1 : top.size();
 
-            // Topics starting with '$' don't match wildcards in the first field
-			// MQTT v5 Spec, Section 4.7.2:
-            // https://docs.oasis-open.org/mqtt/mqtt/v5.0/os/mqtt-v5.0-os.html#_Toc3901246
+                typename node_map::iterator child;
+                const auto map_end = snode.node_->children.end();
 
-            if (!snode.first_ || field.empty() || field[0] != '$') {
-                // Look for a single-field wildcard match
-                if ((child = snode.node_->children.find("+")) != map_end) {
-                    nodes_.push_back({child->second.get(), snode.fields_});
+                // Look for an exact match
+                if ((child = snode.node_->children.find(field)) != map_end) {
+                    push(child->second.get(), pos, more);
                 }
 
-                // Look for a terminating match
-                if ((child = snode.node_->children.find("#")) != map_end) {
-                    // By definition, a '#' is a terminating leaf
-                    pval_ = child->second->content.get();
-                    return;
+                // Topics starting with '$' don't match wildcards in the first field
+                // MQTT v5 Spec, Section 4.7.2:
+                // https://docs.oasis-open.org/mqtt/mqtt/v5.0/os/mqtt-v5.0-os.html#_Toc3901246
+
+                if (!snode.first_ || field.empty() || field[0] != '$') {
+                    // Look for a single-field wildcard match
+                    if ((child = snode.node_->children.find("+")) != map_end) {
+                        push(child->second.get(), pos, more);
+                    }
+
+                    // Look for a terminating match. By definition, a '#' is a
+                    // terminating leaf, apart from any shared subscriptions.
+                    if ((child = snode.node_->children.find("#")) != map_end) {
+                        push(child->second.get(), pos, false);
+                    }
                 }
             }
-
-            this->next();
         }
 
         friend class topic_matcher;
 
         match_iterator() : pval_{nullptr} {}
         match_iterator(value_type* pval) : pval_{pval} {}
-        match_iterator(node* root, const string& topic) : pval_{nullptr} {
-            auto v = topic::split(topic);
-            std::forward_list<string> fields{v.begin(), v.end()};
-            nodes_.push_back(search_node{root, std::move(fields), true});
-            next();
+        match_iterator(node* root, std::string_view topic)
+            : pval_{nullptr}, topicView_{topic} {
+            start(root);
+        }
+        match_iterator(node* root, string&& topic)
+            : pval_{nullptr}, topicStr_{std::move(topic)}, ownsTopic_{true} {
+            start(root);
         }
 
     public:
@@ -386,6 +578,15 @@ public:
          * @return A const pointer to the current value.
          */
         const value_type* operator->() const noexcept { return pval_; }
+        /**
+         * Gets the parts of the topic that matched the wildcards of the
+         * current filter.
+         * These are views into the topic, which must outlive them. If the
+         * iterator took ownership of the topic, they're only valid for the
+         * life of the iterator.
+         * @return The captures for the current filter.
+         */
+        topic_captures captures() const { return topic_captures{pval_->first, topic()}; }
         /**
          * Postfix increment operator.
          * @return An iterator pointing to the previous matching item.
@@ -423,7 +624,7 @@ public:
         using base = match_iterator;
 
         friend class topic_matcher;
-        const_match_iterator(match_iterator it) : base(it) {}
+        const_match_iterator(match_iterator it) : base(std::move(it)) {}
 
     public:
         /**
@@ -466,14 +667,22 @@ public:
      * @return @em true if the collection is empty, @em false if it contains
      *         any filters.
      */
-    bool empty() const { return root_.empty(); }
+    bool empty() const { return root_->empty(); }
+    /**
+     * Gets the generation of the contents of the collection.
+     * This changes whenever a value is inserted or removed, which
+     * invalidates any pointers to the values, so it can be used to tell if
+     * saved match results are still valid.
+     * @return The generation of the contents of the collection.
+     */
+    uint64_t generation() const { return gen_; }
     /**
      * Inserts a new key/value pair into the collection.
      * @param val The value to place in the collection.
      */
     void insert(value_type&& val) {
         auto nd = root_.get();
-        auto fields = topic::split(val.first);
+        auto fields = key_path(val.first);
 
         for (const auto& field : fields) {
             auto it = nd->children.find(field);
@@ -484,6 +693,7 @@ public:
             nd = it->second.get();
         }
         nd->content = std::make_unique<value_type>(std::move(val));
+        ++gen_;
     }
     /**
      * Inserts a new value into the collection.
@@ -504,7 +714,7 @@ public:
      */
     mapped_ptr remove(const key_type& filter) {
         auto nd = root_.get();
-        auto fields = topic::split(filter);
+        auto fields = key_path(filter);
 
         for (auto& field : fields) {
             auto it = nd->children.find(field);
@@ -515,6 +725,8 @@ public:
         }
         value_ptr valpair;
         nd->content.swap(valpair);
+        if (valpair)
+            ++gen_;
 
         return (valpair) ? std::make_unique<mapped_type>(valpair->second) : mapped_ptr{};
     }
@@ -556,7 +768,7 @@ public:
      */
     iterator find(const key_type& filter) {
         auto nd = root_.get();
-        auto fields = topic::split(filter);
+        auto fields = key_path(filter);
 
         for (auto& field : fields) {
             auto it = nd->children.find(field);
@@ -577,16 +789,76 @@ public:
     }
     /**
      * Gets an match_iterator that can find the matches to the topic.
+     * The iterator keeps its own copy of the topic string.
+     * @param topic The topic to search for matches.
+     * @return An iterator that can find the matches to the topic.
+     */
+    match_iterator matches(const string& topic) {
+        return match_iterator(root_.get(), string{topic});
+    }
+    /**
+     * Gets an match_iterator that can find the matches to the topic.
+     * The iterator keeps its own copy of the topic string.
+     * @param topic The topic to search for matches.
+     * @return An iterator that can find the matches to the topic.
+     */
+    match_iterator matches(const char* topic) {
+        return match_iterator(root_.get(), string{topic});
+    }
+    /**
+     * Gets an match_iterator that can find the matches to the topic.
+     * The iterator takes ownership of the temporary topic string.
      * @param topic The topic to search for matches.
      * @return An iterator that can find the matches to the topic.
      */
-    match_iterator matches(const string& topic) { return match_iterator(root_.get(), topic); }
+    match_iterator matches(string&& topic) {
+        return match_iterator(root_.get(), std::move(topic));
+    }
+    /**
+     * Gets an match_iterator that can find the matches to the topic,
+     * without copying it.
+     * The iterator refers to the caller's topic, which must outlive it.
+     * @param topic The topic to search for matches.
+     * @return An iterator that can find the matches to the topic.
+     */
+    match_iterator matches(std::string_view topic) {
+        return match_iterator(root_.get(), topic);
+    }
     /**
      * Gets a const iterator that can find the matches to the topic.
+     * The iterator keeps its own copy of the topic string.
      * @param topic The topic to search for matches.
      * @return A const iterator that can find the matches to the topic.
      */
     const_match_iterator matches(const string& topic) const {
+        return match_iterator(root_.get(), string{topic});
+    }
+    /**
+     * Gets a const iterator that can find the matches to the topic.
+     * The iterator keeps its own copy of the topic string.
+     * @param topic The topic to search for matches.
+     * @return A const iterator that can find the matches to the topic.
+     */
+    const_match_iterator matches(const char* topic) const {
+        return match_iterator(root_.get(), string{topic});
+    }
+    /**
+     * Gets a const iterator that can find the matches to the topic.
+     * The iterator takes ownership of the temporary topic string.
+     * @param topic The topic to search for matches.
+     * @return A const iterator that can find the matches to the topic.
+     */
+    const_match_iterator matches(string&& topic) const {
+        return match_iterator(root_.get(), std::move(topic));
+    }
+    /**
+     * Gets a const iterator that can find the matches to the topic,
+     * without copying it.
+     * The iterator refers to the caller's topic, which must outlive it.
+     * @param topic The topic to search for matches.
+     * @return A const iterator that can find the matches to the topic.
+     */
+    const_match_iterator matches(std::string_view topic) const {
         return match_iterator(root_.get(), topic);
     }
     /**
@@ -613,7 +885,94 @@ public:
      * @return Whether there are any matches for the topic in the
      *         collection.
      */
-    bool has_match(const string& topic) { return matches(topic) != matches_cend(); }
+    bool has_match(const string& topic) {
+        return matches(std::string_view{topic}) != matches_cend();
+    }
+    /**
+     * Matches a batch of topics in a single call.
+     *
+     * The topics are sorted internally, so that the work of searching the
+     * leading fields that neighboring topics have in common is only done
+     * once. A large batch can also be split across a number of threads.
+     * @par
+     * The results are appended to the output vector as pairs of the index
+     * of the topic in the batch and a pointer to a matching value. They are
+     * sorted by the index of the topic, but the values for any one topic
+     * are in no particular order. The pointers are valid until the
+     * collection is changed.
+     *
+     * @param topics A container of the topics to match, such as a vector
+     *  			 of strings or string views.
+     * @param out The vector to receive the results.
+     * @param nThreads The maximum number of threads to use. Small batches
+     *  			   are always matched on the calling thread.
+     * @return The number of results added to the output.
+     */
+    template <typename Topics>
+    size_t match_batch(
+        const Topics& topics, std::vector<batch_result>& out, size_t nThreads = 1
+    ) const {
+        std::vector<std::string_view> views;
+        for (const auto& topic : topics) views.emplace_back(topic);
+
+        const size_t n = views.size(), n0 = out.size();
+
+        // Recorded data is often already in order, so only sort if needed.
+        std::vector<size_t> order(n);
+        for (size_t i = 0; i < n; ++i) order[i] = i;
+
+        auto byTopic = [&views](size_t a, size_t b) { return views[a] < views[b]; };
+        bool sorted = std::is_sorted(order.begin(), order.end(), byTopic);
+        if (!sorted)
+            std::sort(order.begin(), order.end(), byTopic);
+
+        nThreads = std::max(size_t(1), std::min(nThreads, n / MIN_BATCH_PER_THREAD));
+
+        if (nThreads == 1) {
+            match_sorted(views, order.data(), order.data() + n, out);
+        }
+        else {
+            std::vector<std::vector<batch_result>> outs(nThreads);
+            std::vector<std::exception_ptr> errs(nThreads);
+            std::vector<std::thread> thrs;
+            thrs.reserve(nThreads);
+
+            try {
+                for (size_t i = 0; i < nThreads; ++i) {
+                    auto first = order.data() + (n * i / nThreads),
+                         last = order.data() + (n * (i + 1) / nThreads);
+                    thrs.emplace_back([&, i, first, last] {
+                        try {
+                            match_sorted(views, first, last, outs[i]);
+                        }
+                        catch (...) {
+                            errs[i] = std::current_exception();
+                        }
+                    });
+                }
+            }
+            catch (...) {
+                // Couldn't start a thread. Wait for the ones that did start.
+                for (auto& thr : thrs) thr.join();
+                throw;
+            }
+            for (auto& thr : thrs) thr.join();
+
+            for (auto& err : errs) {
+                if (err)
+                    std::rethrow_exception(err);
+            }
+            for (auto& v : outs) out.insert(out.end(), v.begin(), v.end());
+        }
+
+        if (!sorted) {
+            std::stable_sort(
+                out.begin() + n0, out.end(),
+                [](const batch_result& a, const batch_result& b) { return a.first < b.first; }
+            );
+        }
+        return out.size() - n0;
+    }
 };
 
 /////////////////////////////////////////////////////////////////////////////
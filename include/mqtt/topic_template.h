@@ -0,0 +1,204 @@
+/////////////////////////////////////////////////////////////////////////////
+/// @file topic_template.h
+/// Declaration of MQTT topic_template class
+/// @date 16-Oct-2026
+/////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#ifndef __mqtt_topic_template_h
+#define __mqtt_topic_template_h
+
+#include <charconv>
+#include <cstddef>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+#include "mqtt/types.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A pattern for making topic names from field values, such as
+ * "site/{}/sensor/{}".
+ *
+ * Each "{}" in the pattern is a placeholder that is replaced by a value
+ * when the topic is formatted. The values can be strings or integers.
+ * @par
+ * The pattern is parsed and checked once, when the template is created.
+ * It must not be empty, can't contain the wildcards '+' or '#', or a NUL,
+ * and every brace must be part of a placeholder. The constructor is
+ * @em constexpr, so when the template is declared @em constexpr, a bad
+ * pattern fails to compile, and the number of placeholders can be checked
+ * with a `static_assert`.
+ * @par
+ * Formatting into a reused buffer doesn't allocate any memory, once the
+ * buffer has grown to fit the topics. The formatted topic isn't checked;
+ * that's done when it is published.
+ * @par
+ * The template refers to the pattern string, which must outlive it. This
+ * is normally a string literal.
+ *
+ * @code
+ * constexpr mqtt::topic_template SENSOR{"site/{}/sensor/{}"};
+ * static_assert(SENSOR.size() == 2);
+ *
+ * std::string buf;
+ * cli.publish(SENSOR.format_to(buf, siteId, name), payload);
+ * @endcode
+ */
+class topic_template
+{
+public:
+    /** The most placeholders that a pattern can have */
+    static constexpr size_t MAX_FIELDS = 16;
+
+private:
+    /** The pattern */
+    std::string_view pattern_;
+    /** The positions of the placeholders in the pattern */
+    size_t pos_[MAX_FIELDS]{};
+    /** The number of placeholders */
+    size_t n_{0};
+
+    /** Appends a value to the buffer */
+    static void append(string& buf, std::string_view val) { buf.append(val); }
+    /** Appends an integer value to the buffer */
+    template <typename T>
+    static void append_int(string& buf, T val) {
+        char num[24];
+        auto res = std::to_chars(num, num + sizeof(num), val);
+        buf.append(num, size_t(res.ptr - num));
+    }
+    /** Appends the text up to the next placeholder, then its value */
+    template <typename T>
+    void append_field(string& buf, size_t& i, const T& val) const {
+        auto start = (i == 0) ? size_t(0) : pos_[i - 1] + 2;
+        buf.append(pattern_.substr(start, pos_[i] - start));
+        if constexpr (std::is_integral_v<T>) {
+            static_assert(
+                !std::is_same_v<T, bool> && !std::is_same_v<T, char>,
+                "topic fields must be strings or integers"
+            );
+            append_int(buf, val);
+        }
+        else {
+            append(buf, std::string_view{val});
+        }
+        ++i;
+    }
+
+public:
+    /**
+     * Creates an empty template, which has no pattern.
+     */
+    constexpr topic_template() = default;
+    /**
+     * Creates a template from a pattern.
+     * @param pattern The pattern, with a "{}" for each field. This must
+     *  			  outlive the template.
+     * @throw std::invalid_argument if the pattern is empty, has a wildcard
+     *  	  or NUL, or a brace that isn't part of a placeholder.
+     * @throw std::length_error if the pattern has more than @ref
+     *  	  MAX_FIELDS placeholders.
+     */
+    explicit constexpr topic_template(std::string_view pattern) : pattern_{pattern} {
+        if (pattern.empty())
+            throw std::invalid_argument{"empty topic template"};
+
+        for (size_t i = 0; i < pattern.size(); ++i) {
+            switch (pattern[i]) {
+                case '{':
+                    if (i + 1 == pattern.size() || pattern[i + 1] != '}')
+                        throw std::invalid_argument{"unmatched '{' in topic template"};
+                    if (n_ == MAX_FIELDS)
+                        throw std::length_error{"too many fields in topic template"};
+                    pos_[n_++] = i++;
+                    break;
+
+                case '}':
+                    throw std::invalid_argument{"unmatched '}' in topic template"};
+
+                case '+':
+                case '#':
+                    throw std::invalid_argument{"wildcard in topic template"};
+
+                case '\0':
+                    throw std::invalid_argument{"NUL character in topic template"};
+            }
+        }
+    }
+    /**
+     * Gets the pattern.
+     * @return The pattern.
+     */
+    constexpr std::string_view pattern() const { return pattern_; }
+    /**
+     * Gets the number of placeholders in the pattern.
+     * @return The number of placeholders in the pattern.
+     */
+    constexpr size_t size() const { return n_; }
+    /**
+     * Determines if the pattern has no placeholders.
+     * @return @em true if the pattern has no placeholders, @em false
+     *  	   otherwise.
+     */
+    constexpr bool empty() const { return n_ == 0; }
+    /**
+     * Makes a topic name from the pattern and field values, in a buffer.
+     * The buffer is overwritten, and keeps its capacity, so reusing it for
+     * each topic avoids any allocation once it has grown large enough.
+     * @param buf The buffer for the topic name.
+     * @param vals The values for the placeholders, in order. These can be
+     *  		   integers, or anything that converts to a string view.
+     * @return A reference to the buffer.
+     * @throw std::invalid_argument if the number of values doesn't match
+     *  	  the number of placeholders.
+     */
+    template <typename... Args>
+    const string& format_to(string& buf, const Args&... vals) const {
+        if (sizeof...(Args) != n_)
+            throw std::invalid_argument{"wrong number of topic template fields"};
+
+        buf.clear();
+        [[maybe_unused]] size_t i = 0;
+        (append_field(buf, i, vals), ...);
+        buf.append(pattern_.substr((n_ == 0) ? 0 : pos_[n_ - 1] + 2));
+        return buf;
+    }
+    /**
+     * Makes a topic name from the pattern and field values.
+     * @param vals The values for the placeholders, in order.
+     * @return The topic name.
+     * @throw std::invalid_argument if the number of values doesn't match
+     *  	  the number of placeholders.
+     */
+    template <typename... Args>
+    string format(const Args&... vals) const {
+        string buf;
+        format_to(buf, vals...);
+        return buf;
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
+
+#endif  // __mqtt_topic_template_h
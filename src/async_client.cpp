@@ -19,6 +19,7 @@
 
 #include "mqtt/async_client.h"
 
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>
 #include <cstdio>
@@ -30,6 +31,7 @@
 #include "mqtt/message.h"
 #include "mqtt/response_options.h"
 #include "mqtt/token.h"
+#include "mqtt/topic.h"
 
 #define UNUSED(x) (void)(x)
 
@@ -86,6 +88,40 @@ void async_client::create()
 
 async_client::~async_client() { MQTTAsync_destroy(&cli_); }
 
+namespace {
+
+// Gets the most topic aliases that the server will accept on the connection
+// made by the connect token, which is zero if it didn't say, or it's not a
+// v5 connection.
+uint16_t server_topic_alias_maximum(const token_ptr& tok)
+{
+    if (!tok || !tok->is_complete() || tok->get_return_code() != MQTTASYNC_SUCCESS)
+        return 0;
+
+    try {
+        auto rsp = tok->get_connect_response();
+        const auto& props = rsp.get_properties();
+        if (props.contains(property::TOPIC_ALIAS_MAXIMUM))
+            return get<uint16_t>(props, property::TOPIC_ALIAS_MAXIMUM);
+    }
+    catch (const std::exception&) {
+    }
+    return 0;
+}
+
+// Gets the topic alias of an incoming message, or zero if it has none.
+uint16_t topic_alias(const MQTTAsync_message& msg)
+{
+    const auto& cprops = msg.properties;
+    for (int i = 0; i < cprops.count; ++i) {
+        if (cprops.array[i].identifier == MQTTPROPERTY_CODE_TOPIC_ALIAS)
+            return uint16_t(cprops.array[i].value.integer2);
+    }
+    return 0;
+}
+
+}  // namespace
+
 // --------------------------------------------------------------------------
 // Class static callbacks.
 // These are the callbacks directly from the C-lib. In each case the
@@ -107,6 +143,16 @@ void async_client::on_connected(void* context, char* cause)
     if (tok)
         tok->on_success(nullptr);
 
+    // Set up the topic aliases before any callback can publish. The token
+    // only has the server's limit for the connection that it was used to
+    // make. An automatic reconnect doesn't update it, so that connection
+    // gets no aliases.
+    bool rspNew = cli->connRspPending_.exchange(false);
+    cli->reset_topic_aliases(rspNew ? server_topic_alias_maximum(tok) : 0);
+
+    // The incoming aliases are cleared with the next message
+    cli->connGen_.fetch_add(1, std::memory_order_release);
+
     callback* cb = cli->userCallback_;
     auto& connHandler = cli->connHandler_;
     auto& que = cli->que_;
@@ -121,7 +167,7 @@ void async_client::on_connected(void* context, char* cause)
             connHandler(cause_str);
 
         if (que)
-            que->put(connected_event{cause_str});
+            que->put_control(connected_event{cause_str});
     }
 }
 
@@ -137,6 +183,7 @@ void async_client::on_connection_lost(void* context, char* cause)
         return;
 
     async_client* cli = static_cast<async_client*>(context);
+    cli->reset_topic_aliases(0);
 
     callback* cb = cli->userCallback_;
     auto& connLostHandler = cli->connLostHandler_;
@@ -152,7 +199,7 @@ void async_client::on_connection_lost(void* context, char* cause)
             connLostHandler(cause_str);
 
         if (que)
-            que->put(connection_lost_event{cause_str});
+            que->put_control(connection_lost_event{cause_str});
     }
 }
 
@@ -177,7 +224,7 @@ void async_client::on_disconnected(
             disconnectedHandler(props, ReasonCode(reasonCode));
 
         if (que)
-            que->put(disconnected_event{std::move(props), ReasonCode(reasonCode)});
+            que->put_control(disconnected_event{std::move(props), ReasonCode(reasonCode)});
     }
 }
 
@@ -195,11 +242,21 @@ int async_client::on_message_arrived(
     callback* cb = cli->userCallback_;
     auto& que = cli->que_;
     auto& msgHandler = cli->msgHandler_;
+    auto& dispatcher = cli->dispatcher_;
+    auto& router = cli->router_;
 
-    if (cb || que || msgHandler) {
+    if (cb || que || msgHandler || dispatcher || !router.empty()) {
         size_t len = (topicLen == 0) ? strlen(topicName) : size_t(topicLen);
 
-        string topic{topicName, len};
+        // The server's aliases are only good for the connection that set them
+        auto gen = cli->connGen_.load(std::memory_order_acquire);
+        if (gen != cli->inTopicsGen_) {
+            cli->inTopics_.clear_aliases();
+            cli->inTopicsGen_ = gen;
+        }
+
+        auto topic =
+            cli->inTopics_.resolve(std::string_view{topicName, len}, topic_alias(*msg));
         auto m = message::create(std::move(topic), *msg);
 
         if (msgHandler)
@@ -210,6 +267,11 @@ int async_client::on_message_arrived(
 
         if (que)
             que->put(m);
+
+        if (dispatcher)
+            dispatcher->dispatch(m);
+
+        router.route(m);
     }
 
     MQTTAsync_freeMessage(&msg);
@@ -381,6 +443,14 @@ void async_client::set_message_callback(message_handler cb)
     );
 }
 
+void async_client::add_route(const string& filter, message_handler handler, route_mode mode)
+{
+    router_.add_route(filter, std::move(handler), mode);
+    check_ret(
+        ::MQTTAsync_setMessageArrivedCallback(cli_, this, &async_client::on_message_arrived)
+    );
+}
+
 void async_client::set_update_connection_handler(update_connection_handler cb)
 {
     updateConnectionHandler_ = cb;
@@ -411,6 +481,10 @@ token_ptr async_client::connect(connect_options opts)
     // happened, the callback would have the context address of the previous
     // token which was destroyed. So for now, keep the old one alive within
     // this function, and check the behavior of the C library...
+    // Aliases are only for the connection that they were made on
+    reset_topic_aliases(0);
+    connRspPending_ = topic_aliases_enabled();
+
     auto tmpTok = connTok_;
     connTok_ = token::create(token::Type::CONNECT, *this);
     add_token(connTok_);
@@ -442,6 +516,9 @@ token_ptr async_client::connect(connect_options opts, void* userContext, iaction
     else
         opts.opts_.cleansession = 0;
 
+    reset_topic_aliases(0);
+    connRspPending_ = topic_aliases_enabled();
+
     // Keep the old connTok_ alive (see above)
     auto tmpTok = connTok_;
     connTok_ = token::create(token::Type::CONNECT, *this, userContext, cb);
@@ -474,6 +551,7 @@ token_ptr async_client::reconnect()
 
     tok->reset();
     add_token(tok);
+    connRspPending_ = topic_aliases_enabled();
 
     int rc = MQTTAsync_setConnected(cli_, this, &async_client::on_connected);
 
@@ -493,6 +571,8 @@ token_ptr async_client::reconnect()
 
 token_ptr async_client::disconnect(disconnect_options opts)
 {
+    reset_topic_aliases(0);
+
     auto tok = token::create(token::Type::DISCONNECT, *this);
     add_token(tok);
 
@@ -561,9 +641,96 @@ std::vector<delivery_token_ptr> async_client::get_pending_delivery_tokens() cons
     return toks;
 }
 
+// --------------------------------------------------------------------------
+// Topic aliases
+
+void async_client::enable_topic_aliases(uint16_t maxAliases)
+{
+    if (maxAliases != 0) {
+        check_ret(::MQTTAsync_setConnected(cli_, this, &async_client::on_connected));
+        check_ret(::MQTTAsync_setConnectionLostCallback(
+            cli_, this, &async_client::on_connection_lost
+        ));
+    }
+
+    guard g(aliasLock_);
+    aliasLimit_ = maxAliases;
+
+    // If already connected, start with the limit of the current connection,
+    // if it's known. If aliases were off when it connected, the connect
+    // token has the limit, unless the client could have since reconnected
+    // on its own.
+    uint16_t serverMax = 0;
+    if (is_connected()) {
+        serverMax = aliasServerMax_;
+        if (serverMax == 0 && !connOpts_.get_automatic_reconnect())
+            serverMax = server_topic_alias_maximum(connTok_);
+    }
+    aliases_.reset(std::min(aliasLimit_, serverMax));
+}
+
+bool async_client::topic_aliases_enabled() const
+{
+    guard g(aliasLock_);
+    return aliasLimit_ != 0;
+}
+
+void async_client::reset_topic_aliases(uint16_t serverMax)
+{
+    guard g(aliasLock_);
+    aliasServerMax_ = serverMax;
+    aliases_.reset(std::min(aliasLimit_, serverMax));
+}
+
+// Sends a message, giving its topic an alias, if they're enabled. The lock
+// is held while the message is queued, so that the first message with a
+// new alias is always sent ahead of any that only carry the alias.
+int async_client::send_message(const message& msg, MQTTAsync_responseOptions& opts)
+{
+    const auto& topic = msg.get_topic();
+
+    // QoS 1 and 2 messages can be resent on a new connection, where an
+    // alias from this one would be a protocol error, so only QoS 0 gets one.
+    unique_lock g(aliasLock_);
+    if (!aliases_.enabled() || topic.empty() || msg.get_qos() != 0 ||
+        msg.get_properties().contains(property::TOPIC_ALIAS)) {
+        g.unlock();
+        return MQTTAsync_sendMessage(cli_, topic.c_str(), &msg.msg_, &opts);
+    }
+
+    auto [alias, isNew] = aliases_.assign(topic);
+
+    properties props{msg.get_properties()};
+    props.add({property::TOPIC_ALIAS, int32_t(alias)});
+
+    auto cmsg = msg.msg_;
+    cmsg.properties = props.c_struct();
+
+    int rc = MQTTAsync_sendMessage(cli_, isNew ? topic.c_str() : "", &cmsg, &opts);
+
+    if (rc != MQTTASYNC_SUCCESS && isNew)
+        aliases_.remove(topic);
+    return rc;
+}
+
 // --------------------------------------------------------------------------
 // Publish
 
+namespace {
+
+// Checks the topic of an outgoing message, so that a bad one fails here,
+// rather than getting the client disconnected by the server. An MQTT v5
+// message can have an empty topic if it's sent with a topic alias.
+void check_topic(const message& msg)
+{
+    const auto& name = msg.get_topic();
+    if (name.empty() && msg.get_properties().contains(property::TOPIC_ALIAS))
+        return;
+    topic::validate_name(name);
+}
+
+}  // namespace
+
 delivery_token_ptr async_client::publish(
     string_ref topic, const void* payload, size_t n, int qos, bool retained,
     const properties& props /*=properties()*/
@@ -593,13 +760,14 @@ delivery_token_ptr async_client::publish(
 
 delivery_token_ptr async_client::publish(const_message_ptr msg)
 {
+    check_topic(*msg);
+
     auto tok = delivery_token::create(*this, msg);
     add_token(tok);
 
     delivery_response_options rspOpts(tok, mqttVersion_);
 
-    int rc =
-        MQTTAsync_sendMessage(cli_, msg->get_topic().c_str(), &(msg->msg_), &rspOpts.opts_);
+    int rc = send_message(*msg, rspOpts.opts_);
 
     if (rc == MQTTASYNC_SUCCESS) {
         tok->set_message_id(rspOpts.opts_.token);
@@ -616,13 +784,14 @@ delivery_token_ptr async_client::publish(
     const_message_ptr msg, void* userContext, iaction_listener& cb
 )
 {
+    check_topic(*msg);
+
     delivery_token_ptr tok = delivery_token::create(*this, msg, userContext, cb);
     add_token(tok);
 
     delivery_response_options rspOpts(tok, mqttVersion_);
 
-    int rc =
-        MQTTAsync_sendMessage(cli_, msg->get_topic().c_str(), &(msg->msg_), &rspOpts.opts_);
+    int rc = send_message(*msg, rspOpts.opts_);
 
     if (rc == MQTTASYNC_SUCCESS) {
         tok->set_message_id(rspOpts.opts_.token);
@@ -690,6 +859,31 @@ token_ptr async_client::subscribe(
     return tok;
 }
 
+token_ptr async_client::subscribe(
+    const string& topicFilter, int qos, message_handler handler, route_mode mode,
+    const subscribe_options& opts /*=subscribe_options()*/,
+    const properties& props /*=properties()*/
+)
+{
+    if (mqttVersion_ < MQTTVERSION_5) {
+        add_route(topicFilter, std::move(handler), mode);
+        return subscribe(topicFilter, qos, opts, props);
+    }
+
+    if (props.contains(property::SUBSCRIPTION_IDENTIFIER))
+        throw std::invalid_argument("The route assigns the subscription identifier");
+
+    auto id = router_.add_subscription_route(topicFilter, std::move(handler), mode);
+    check_ret(
+        ::MQTTAsync_setMessageArrivedCallback(cli_, this, &async_client::on_message_arrived)
+    );
+
+    properties subProps{props};
+    subProps.add({property::SUBSCRIPTION_IDENTIFIER, id});
+
+    return subscribe(topicFilter, qos, opts, subProps);
+}
+
 token_ptr async_client::subscribe(
     const_string_collection_ptr topicFilters, const qos_collection& qos,
     const std::vector<subscribe_options>& opts
@@ -852,7 +1046,9 @@ token_ptr async_client::unsubscribe(
 
 // --------------------------------------------------------------------------
 
-void async_client::start_consuming()
+void async_client::start_consuming() { start_consuming(consumer_queue_type{}); }
+
+void async_client::start_consuming(consumer_queue_type que)
 {
     // Make sure callbacks don't happen while we update the que, etc
     disable_callbacks();
@@ -860,7 +1056,37 @@ void async_client::start_consuming()
     // TODO: Should we replace user callback?
     // userCallback_ = nullptr;
 
-    que_.reset(new thread_queue<event>);
+    if (!que)
+        que = consumer_queue<>::create();
+
+    que_ = std::move(que);
+    dispatcher_.reset();
+
+    int rc = MQTTAsync_setCallbacks(
+        cli_, this, &async_client::on_connection_lost, &async_client::on_message_arrived,
+        nullptr
+    );
+
+    check_ret(rc);
+    check_ret(::MQTTAsync_setConnected(cli_, this, &async_client::on_connected));
+    check_ret(::MQTTAsync_setDisconnected(cli_, this, &async_client::on_disconnected));
+}
+
+void async_client::start_consuming(size_t capacity, overflow_policy policy)
+{
+    start_consuming(consumer_queue<>::create(capacity, policy));
+}
+
+void async_client::start_consuming(
+    size_t nWorkers, message_handler handler, const dispatch_options& opts
+)
+{
+    // Make sure callbacks don't happen while we update the workers, etc
+    disable_callbacks();
+
+    que_.reset();
+    dispatcher_.reset();
+    dispatcher_ = std::make_unique<sharded_dispatcher>(nWorkers, std::move(handler), opts);
 
     int rc = MQTTAsync_setCallbacks(
         cli_, this, &async_client::on_connection_lost, &async_client::on_message_arrived,
@@ -878,10 +1104,14 @@ void async_client::stop_consuming()
         disable_callbacks();
         if (que_)
             que_->close();
+        if (dispatcher_)
+            dispatcher_->stop();
     }
     catch (...) {
         if (que_)
             que_->close();
+        if (dispatcher_)
+            dispatcher_->stop();
         throw;
     }
 }
@@ -929,6 +1159,61 @@ const_message_ptr async_client::consume_message()
     }
 }
 
+size_t async_client::consume_events(std::vector<event>& evts, size_t maxEvents)
+{
+    if (!que_)
+        throw mqtt::exception(-1, "Consumer not started");
+
+    if (maxEvents == 0)
+        return 0;
+
+    auto n = que_->get_n(evts, maxEvents);
+    if (n == 0) {
+        // The queue must be done
+        evts.emplace_back(shutdown_event{});
+        n = 1;
+    }
+    return n;
+}
+
+size_t async_client::events_to_messages(
+    std::vector<event>& evts, std::vector<const_message_ptr>& msgs
+)
+{
+    size_t n = 0;
+    for (auto& evt : evts) {
+        if (auto pmsg = evt.get_message_if()) {
+            msgs.push_back(std::move(*pmsg));
+            ++n;
+        }
+        else if (evt.is_any_disconnect()) {
+            msgs.push_back(const_message_ptr{});
+            ++n;
+        }
+    }
+    return n;
+}
+
+std::vector<event>& async_client::event_buffer()
+{
+    thread_local std::vector<event> evts;
+    evts.clear();
+    return evts;
+}
+
+size_t async_client::consume_messages(std::vector<const_message_ptr>& msgs, size_t maxMsgs)
+{
+    auto& evts = event_buffer();
+
+    // Keep going until we get something other than 'connected' events
+    size_t n = 0;
+    while (n == 0 && consume_events(evts, maxMsgs) > 0) {
+        n = events_to_messages(evts, msgs);
+        evts.clear();
+    }
+    return n;
+}
+
 bool async_client::try_consume_message(const_message_ptr* msg)
 {
     if (!que_)
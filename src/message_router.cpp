@@ -0,0 +1,251 @@
+// message_router.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/message_router.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Finds the position of a subscription identifier in a table sorted by id.
+template <typename Table>
+auto find_id(Table& ids, uint32_t id)
+{
+    return std::lower_bound(
+        ids.begin(), ids.end(), id,
+        [](const typename Table::value_type& v, uint32_t id) { return v.first < id; }
+    );
+}
+
+}  // namespace
+
+/////////////////////////////////////////////////////////////////////////////
+
+message_router::message_router() : ids_{std::make_shared<const id_table>()} {}
+
+message_router::~message_router()
+{
+    if (workers_)
+        workers_->stop();
+}
+
+// Finds the routes for a message by its subscription identifiers if it has
+// any, and every route has one, otherwise by matching its topic.
+template <typename Fn>
+std::size_t message_router::for_each_route(const message& msg, Fn fn) const
+{
+    if (nPlain_.load(std::memory_order_acquire) == 0) {
+        const auto& cprops = msg.get_properties().c_struct();
+
+        auto is_id = [](const MQTTProperty& prop) {
+            return prop.identifier == MQTTPROPERTY_CODE_SUBSCRIPTION_IDENTIFIER;
+        };
+        auto end = cprops.array + cprops.count;
+
+        if (cprops.count > 0 && std::find_if(cprops.array, end, is_id) != end) {
+            return ids_.with_local([&](const id_table& ids) {
+                std::size_t n = 0;
+                for (auto prop = cprops.array; prop != end; ++prop) {
+                    if (!is_id(*prop))
+                        continue;
+
+                    auto id = uint32_t(prop->value.integer4);
+                    auto it = find_id(ids, id);
+                    if (it != ids.end() && it->first == id) {
+                        fn(it->second);
+                        ++n;
+                    }
+                }
+                return n;
+            });
+        }
+    }
+
+    return routes_.for_each_match(msg.get_topic(), [&](const auto& val) { fn(val.second); });
+}
+
+bool message_router::start_workers(std::size_t nWorkers, const dispatch_options& opts)
+{
+    std::lock_guard<std::mutex> g{lock_};
+    if (workers_)
+        return false;
+
+    // Messages are always sharded by topic, so that the messages for each
+    // topic are handled in order.
+    dispatch_options wopts{opts};
+    wopts.key = nullptr;
+
+    // Each message is queued with the handlers of its worker routes, so
+    // the default handler is never used.
+    workers_ =
+        std::make_unique<sharded_dispatcher>(nWorkers, [](const_message_ptr) {}, wopts);
+    pworkers_.store(workers_.get(), std::memory_order_release);
+    return true;
+}
+
+// The identifiers are never reused. The server's subscription for a
+// removed route is still live, and messages already on their way still
+// carry its identifier, so a reused one would send them to the wrong route.
+uint32_t message_router::next_id()
+{
+    if (nextId_ > MAX_SUBSCRIPTION_ID)
+        throw std::out_of_range("No more subscription identifiers");
+    return nextId_++;
+}
+
+template <typename Fn>
+void message_router::update_ids(Fn fn)
+{
+    auto ids = std::make_shared<id_table>(*ids_.load());
+    fn(*ids);
+    ids_.store(std::move(ids));
+}
+
+uint32_t message_router::add(
+    const string& filter, handler_type handler, route_mode mode, bool withId
+)
+{
+    if (!handler)
+        throw std::invalid_argument("A route requires a message handler");
+
+    if (mode == route_mode::worker && !has_workers())
+        start_workers(std::thread::hardware_concurrency());
+
+    std::lock_guard<std::mutex> g{lock_};
+
+    auto snap = routes_.snapshot();
+    auto it = snap->find(filter);
+    bool replaced = (it != snap->cend());
+    uint32_t oldId = replaced ? it->second.subId : 0;
+
+    uint32_t id = withId ? (oldId ? oldId : next_id()) : 0;
+    route_entry rte{std::make_shared<const handler_type>(std::move(handler)), mode, id};
+
+    if (id || oldId) {
+        update_ids([&](id_table& ids) {
+            auto it = find_id(ids, id ? id : oldId);
+            if (!id)
+                ids.erase(it);
+            else if (it != ids.end() && it->first == id)
+                it->second = rte;
+            else
+                ids.emplace(it, id, rte);
+        });
+    }
+
+    routes_.insert({filter, std::move(rte)});
+
+    if (!id && (!replaced || oldId))
+        nPlain_.fetch_add(1, std::memory_order_release);
+    else if (id && replaced && !oldId)
+        nPlain_.fetch_sub(1, std::memory_order_release);
+
+    if (!replaced)
+        nRoutes_.fetch_add(1, std::memory_order_release);
+
+    return id;
+}
+
+uint32_t message_router::subscription_id(const string& filter) const
+{
+    auto snap = routes_.snapshot();
+    auto it = snap->find(filter);
+    return (it != snap->cend()) ? it->second.subId : 0;
+}
+
+bool message_router::remove_route(const string& filter)
+{
+    std::lock_guard<std::mutex> g{lock_};
+
+    auto rte = routes_.remove(filter);
+    if (!rte)
+        return false;
+
+    if (auto id = rte->subId) {
+        update_ids([id](id_table& ids) { ids.erase(find_id(ids, id)); });
+    }
+    else {
+        nPlain_.fetch_sub(1, std::memory_order_release);
+    }
+
+    nRoutes_.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void message_router::clear()
+{
+    std::lock_guard<std::mutex> g{lock_};
+    routes_.update([](auto& tm) { tm = std::decay_t<decltype(tm)>{}; });
+    ids_.store(std::make_shared<const id_table>());
+    nPlain_.store(0, std::memory_order_release);
+    nRoutes_.store(0, std::memory_order_release);
+}
+
+std::size_t message_router::route(const const_message_ptr& msg)
+{
+    if (!msg || empty())
+        return 0;
+
+    // The handlers of the worker routes that matched, as of now
+    std::vector<std::shared_ptr<const handler_type>> workerHandlers;
+
+    auto n = for_each_route(*msg, [&](const route_entry& rte) {
+        if (rte.mode == route_mode::worker) {
+            workerHandlers.push_back(rte.handler);
+            return;
+        }
+        try {
+            (*rte.handler)(msg);
+        }
+        catch (...) {
+            // An error in one handler shouldn't keep the message from the others
+        }
+    });
+
+    if (!workerHandlers.empty()) {
+        if (auto workers = pworkers_.load(std::memory_order_acquire)) {
+            auto run = [handlers = std::move(workerHandlers)](const_message_ptr msg) {
+                for (const auto& handler : handlers) {
+                    try {
+                        (*handler)(msg);
+                    }
+                    catch (...) {
+                        // An error in one handler shouldn't keep the message from the others
+                    }
+                }
+            };
+            try {
+                workers->dispatch(msg, std::move(run));
+            }
+            catch (const queue_closed&) {
+                // The router is shutting down
+            }
+        }
+    }
+    return n;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -0,0 +1,170 @@
+// sharded_dispatcher.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/sharded_dispatcher.h"
+
+#include <algorithm>
+#include <string_view>
+
+#if defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Pins a thread to a CPU, if the platform supports it.
+void set_thread_cpu(std::thread& thr, int cpu)
+{
+#if defined(__linux__)
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    ::pthread_setaffinity_np(thr.native_handle(), sizeof(cpu_set_t), &cpus);
+#else
+    (void)thr;
+    (void)cpu;
+#endif
+}
+
+// Names a thread, if the platform supports it.
+void set_thread_name(std::thread& thr, const string& name)
+{
+#if defined(__linux__)
+    // Linux limits names to 15 chars, plus the NUL terminator
+    ::pthread_setname_np(thr.native_handle(), name.substr(0, 15).c_str());
+#else
+    (void)thr;
+    (void)name;
+#endif
+}
+
+}  // namespace
+
+/////////////////////////////////////////////////////////////////////////////
+
+sharded_dispatcher::sharded_dispatcher(
+    std::size_t nWorkers, handler_type handler, const dispatch_options& opts
+)
+    : handler_{std::make_shared<const handler_type>(std::move(handler))}, keyFn_{opts.key}
+{
+    if (!*handler_)
+        throw std::invalid_argument("The dispatcher requires a message handler");
+
+    if (!keyFn_)
+        keyFn_ = &sharded_dispatcher::topic_key;
+
+    nWorkers = std::max<std::size_t>(nWorkers, 1);
+    workers_.reserve(nWorkers);
+
+    try {
+        for (std::size_t i = 0; i < nWorkers; ++i) {
+            workers_.push_back(std::make_shared<worker>());
+            auto& w = *workers_.back();
+            w.thr = std::thread(&sharded_dispatcher::run, workers_.back(), handler_);
+
+            if (!opts.cpus.empty())
+                set_thread_cpu(w.thr, opts.cpus[i % opts.cpus.size()]);
+
+            if (!opts.threadName.empty())
+                set_thread_name(w.thr, opts.threadName + std::to_string(i));
+        }
+    }
+    catch (...) {
+        // The destructor won't run, so shut down the workers already started
+        stop();
+        throw;
+    }
+}
+
+sharded_dispatcher::~sharded_dispatcher()
+{
+    stop();
+
+    // Destroyed by one of our own handlers. That worker can't be joined,
+    // but it only uses its own shared state, so it can safely run on.
+    for (auto& w : workers_) {
+        if (w->thr.joinable())
+            w->thr.detach();
+    }
+}
+
+std::size_t sharded_dispatcher::topic_key(const message& msg)
+{
+    return std::hash<std::string_view>{}(std::string_view{msg.get_topic()});
+}
+
+std::size_t sharded_dispatcher::shard_of(const message& msg) const
+{
+    return keyFn_(msg) % workers_.size();
+}
+
+void sharded_dispatcher::dispatch(const_message_ptr msg)
+{
+    dispatch(std::move(msg), handler_type{});
+}
+
+void sharded_dispatcher::dispatch(const_message_ptr msg, handler_type handler)
+{
+    if (msg) {
+        auto& w = *workers_[shard_of(*msg)];
+        w.que.put(work_item{std::move(msg), std::move(handler)});
+    }
+}
+
+void sharded_dispatcher::run(
+    std::shared_ptr<worker> w, std::shared_ptr<const handler_type> handler
+)
+{
+    work_item item;
+    while (w->que.get(&item)) {
+        try {
+            if (item.handler)
+                item.handler(std::move(item.msg));
+            else
+                (*handler)(std::move(item.msg));
+        }
+        catch (...) {
+            // An error in the handler shouldn't take down the worker
+        }
+        // Don't hold on to the message's handler while waiting
+        item.handler = nullptr;
+    }
+}
+
+void sharded_dispatcher::stop()
+{
+    for (auto& w : workers_) w->que.close();
+
+    for (auto& w : workers_) {
+        if (!w->thr.joinable())
+            continue;
+
+        // A handler that stops the dispatcher can't wait for itself. Its
+        // thread is left joinable, for the destructor.
+        if (w->thr.get_id() != std::this_thread::get_id())
+            w->thr.join();
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
@@ -19,33 +19,221 @@
 #include "mqtt/topic.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <stdexcept>
 
 #include "mqtt/async_client.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define PAHO_MQTTPP_TOPIC_SSE2
+    #include <emmintrin.h>
+#endif
+
+#if defined(PAHO_MQTTPP_TOPIC_SSE2) && defined(__GNUC__) && defined(__x86_64__)
+    #define PAHO_MQTTPP_TOPIC_AVX2
+    #include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
 namespace mqtt {
 
 /////////////////////////////////////////////////////////////////////////////
-//  							topic
+//  						Topic scanning
 /////////////////////////////////////////////////////////////////////////////
 
-// This is just a string split around '/'
-std::vector<string> topic::split(const string& s)
+namespace {
+
+// The longest topic that MQTT can encode
+constexpr size_t MAX_TOPIC_LEN = 65535;
+
+// Byte scanners: find the first byte that needs a closer look when
+// validating a topic name: a NUL, a wildcard ('+' or '#'), or the start of
+// a multi-byte UTF-8 character (high bit set). Returns the length if there
+// are none. Most topics are plain ASCII, so this usually runs the length
+// of the topic, a vector at a time.
+
+using scan_fn = size_t (*)(const char*, size_t);
+
+// Checks a single byte, for the scalar scan and the tail of the vector ones.
+inline bool is_special(char c)
 {
-    std::vector<std::string> v;
+    return c == '\0' || c == '+' || c == '#' || (static_cast<unsigned char>(c) & 0x80);
+}
+
+size_t scan_scalar(const char* p, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        if (is_special(p[i]))
+            return i;
+    }
+    return n;
+}
+
+#if defined(PAHO_MQTTPP_TOPIC_SSE2)
+
+// Gets the index of the lowest set bit of a non-zero mask.
+inline unsigned lowest_bit(uint32_t mask)
+{
+    #if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward(&i, mask);
+    return unsigned(i);
+    #else
+    return unsigned(__builtin_ctz(mask));
+    #endif
+}
+
+size_t scan_sse2(const char* p, size_t n)
+{
+    const __m128i nul = _mm_setzero_si128(), plus = _mm_set1_epi8('+'),
+                  hash = _mm_set1_epi8('#');
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, nul), _mm_cmpeq_epi8(v, plus)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, hash), v)
+        );
+        // The high bit of each byte is set for a match or a non-ASCII byte
+        auto mask = uint32_t(_mm_movemask_epi8(m));
+        if (mask)
+            return i + lowest_bit(mask);
+    }
+    return i + scan_scalar(p + i, n - i);
+}
+
+#endif
+
+#if defined(PAHO_MQTTPP_TOPIC_AVX2)
+
+__attribute__((target("avx2"))) size_t scan_avx2(const char* p, size_t n)
+{
+    const __m256i nul = _mm256_setzero_si256(), plus = _mm256_set1_epi8('+'),
+                  hash = _mm256_set1_epi8('#');
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i m = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, nul), _mm256_cmpeq_epi8(v, plus)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, hash), v)
+        );
+        auto mask = uint32_t(_mm256_movemask_epi8(m));
+        if (mask)
+            return i + lowest_bit(mask);
+    }
+    return i + scan_sse2(p + i, n - i);
+}
 
-    if (s.empty())
-        return v;
+#endif
 
-    const auto delim = '/';
-    string::size_type startPos = 0, pos;
+// Picks the fastest scanner that the CPU supports.
+scan_fn select_scan()
+{
+#if defined(PAHO_MQTTPP_TOPIC_AVX2)
+    // This runs from a static initializer, which might be before the one
+    // that detects the CPU features.
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return &scan_avx2;
+#endif
+#if defined(PAHO_MQTTPP_TOPIC_SSE2)
+    return &scan_sse2;
+#else
+    return &scan_scalar;
+#endif
+}
+
+const scan_fn scan_special = select_scan();
+
+// Gets the length of the valid UTF-8 character at the start of the string,
+// or zero if it's not valid. This rejects overlong encodings, surrogates,
+// and code points past U+10FFFF, as required by MQTT.
+size_t utf8_char_len(const unsigned char* p, size_t n)
+{
+    auto cont = [&](size_t i, unsigned char lo = 0x80, unsigned char hi = 0xBF) {
+        return i < n && p[i] >= lo && p[i] <= hi;
+    };
+
+    const auto c = p[0];
+
+    if (c >= 0xC2 && c <= 0xDF)
+        return cont(1) ? 2 : 0;
+
+    if (c >= 0xE0 && c <= 0xEF) {
+        auto lo = (c == 0xE0) ? 0xA0 : 0x80, hi = (c == 0xED) ? 0x9F : 0xBF;
+        return (cont(1, lo, hi) && cont(2)) ? 3 : 0;
+    }
+
+    if (c >= 0xF0 && c <= 0xF4) {
+        auto lo = (c == 0xF0) ? 0x90 : 0x80, hi = (c == 0xF4) ? 0x8F : 0xBF;
+        return (cont(1, lo, hi) && cont(2) && cont(3)) ? 4 : 0;
+    }
+
+    return 0;
+}
+
+// Checks a topic name, returning a description of the first problem, or
+// nullptr if it's valid. The error code is set for any problem.
+const char* check_name(std::string_view name, int& rc)
+{
+    rc = MQTTASYNC_FAILURE;
+
+    if (name.empty())
+        return "A topic name can't be empty";
+
+    if (name.size() > MAX_TOPIC_LEN)
+        return "The topic name is too long";
+
+    const auto p = name.data();
+    const auto n = name.size();
+
+    for (size_t i = scan_special(p, n); i < n; i += scan_special(p + i, n - i)) {
+        if (p[i] == '+' || p[i] == '#')
+            return "A topic name can't contain wildcards";
+
+        rc = MQTTASYNC_BAD_UTF8_STRING;
+        if (p[i] == '\0')
+            return "A topic name can't contain a NUL character";
+
+        auto len = utf8_char_len(reinterpret_cast<const unsigned char*>(p + i), n - i);
+        if (len == 0)
+            return "The topic name is not valid UTF-8";
+        i += len;
+    }
+
+    rc = MQTTASYNC_SUCCESS;
+    return nullptr;
+}
+
+}  // namespace
+
+/////////////////////////////////////////////////////////////////////////////
+//  							topic
+/////////////////////////////////////////////////////////////////////////////
+
+bool topic::is_valid_name(std::string_view name)
+{
+    int rc;
+    return check_name(name, rc) == nullptr;
+}
 
-    do {
-        pos = s.find(delim, startPos);
-        auto n = (pos == string::npos) ? pos : (pos - startPos);
-        v.push_back(s.substr(startPos, n));
-        startPos = pos + 1;
-    } while (pos != string::npos);
+void topic::validate_name(std::string_view name)
+{
+    int rc;
+    if (auto err = check_name(name, rc))
+        throw exception(rc, ReasonCode::TOPIC_NAME_INVALID, err);
+}
 
+// This is just a string split around '/'
+std::vector<string> topic::split(const string& s)
+{
+    std::vector<std::string> v;
+    for (auto field : topic_fields{s}) v.emplace_back(field);
     return v;
 }
 
@@ -69,6 +257,11 @@ delivery_token_ptr topic::publish(binary_ref payload, int qos, bool retained)
     return cli_.publish(name_, std::move(payload), qos, retained);
 }
 
+delivery_token_ptr topic::publish_name(string_ref name, binary_ref payload)
+{
+    return cli_.publish(std::move(name), std::move(payload), qos_, retained_);
+}
+
 token_ptr topic::subscribe(const subscribe_options& opts)
 {
     return cli_.subscribe(name_, qos_, opts);
@@ -78,7 +271,56 @@ token_ptr topic::subscribe(const subscribe_options& opts)
 //  						topic_filter
 /////////////////////////////////////////////////////////////////////////////
 
-topic_filter::topic_filter(const string& filter) : fields_(topic::split(filter)) {}
+namespace {
+
+constexpr std::string_view SHARE_PREFIX{"$share/"};
+
+// Gets the position of the slash after the group name of a shared
+// subscription filter, or npos if this is not a valid shared filter.
+size_t share_sep(std::string_view filter)
+{
+    const auto n = SHARE_PREFIX.size();
+
+    if (filter.substr(0, n) != SHARE_PREFIX)
+        return string::npos;
+
+    auto sep = filter.find('/', n);
+    if (sep == n || sep == string::npos || sep + 1 == filter.size())
+        return string::npos;
+
+    if (filter.find_first_of("+#", n) < sep)
+        return string::npos;
+
+    return sep;
+}
+
+}  // namespace
+
+topic_filter::topic_filter(const string& filter)
+    : fields_(topic::split(strip_share(filter))), group_(share_group(filter))
+{
+}
+
+bool topic_filter::is_shared(const string& filter)
+{
+    return share_sep(filter) != string::npos;
+}
+
+string topic_filter::share_group(const string& filter)
+{
+    auto sep = share_sep(filter);
+    if (sep == string::npos)
+        return string{};
+
+    const auto n = SHARE_PREFIX.size();
+    return filter.substr(n, sep - n);
+}
+
+string topic_filter::strip_share(const string& filter)
+{
+    auto sep = share_sep(filter);
+    return (sep == string::npos) ? filter : filter.substr(sep + 1);
+}
 
 bool topic_filter::has_wildcards(const string& filter)
 {
@@ -102,45 +344,94 @@ bool topic_filter::has_wildcards() const
 }
 
 // See if the topic matches this filter.
-// OPTIMIZE: If the filter string doesn't contain any wildcards, then a
-// match is a simple string comparison. We wouldn't need to split the filter
-// or topic into fields.
-bool topic_filter::matches(const string& topic) const
+// This walks the fields of the topic in place, against the fields of the
+// filter, so it doesn't need to split the topic into strings.
+bool topic_filter::match(std::string_view topic, topic_captures* caps) const
 {
-    auto n = fields_.size();
+    if (caps)
+        *caps = topic_captures{};
 
-    auto topic_fields = topic::split(topic);
-    auto nt = topic_fields.size();
+    // An empty topic has no fields
+    if (topic.empty())
+        return fields_.empty();
 
-    // Filter can't match a topic that is shorter
-    if (n > nt) {
-        return false;
-    }
+    const auto n = fields_.size();
+    topic_fields tfields{topic};
+    auto tf = tfields.begin();
+    size_t pos = 0;
 
-    // Might match a longer topic, but only with '#' wildcard
-    if (n < nt && fields_[n - 1] != "#") {
-        return false;
-    }
+    for (size_t i = 0; i < n; ++i) {
+        const auto& filt = fields_[i];
 
-    // Topics starting with '$' don't match wildcards in the first field
-    // MQTT v5 Spec, Section 4.7.2:
-    // https://docs.oasis-open.org/mqtt/mqtt/v5.0/os/mqtt-v5.0-os.html#_Toc3901246
+        // Topics starting with '$' don't match wildcards in the first field
+        // MQTT v5 Spec, Section 4.7.2:
+        // https://docs.oasis-open.org/mqtt/mqtt/v5.0/os/mqtt-v5.0-os.html#_Toc3901246
 
-    if (n > 0 && is_wildcard(fields_[0]) && nt > 0 && topic_fields[0].size() > 0 &&
-        topic_fields[0][0] == '$') {
-        return false;
-    }
+        if (i == 0 && is_wildcard(filt) && topic[0] == '$')
+            return false;
 
-    for (size_t i = 0; i < n; ++i) {
-        if (fields_[i] == "#") {
-            break;
+        // The '#' matches the rest of the topic, but not its parent
+        if (filt == "#") {
+            if (tf == tfields.end())
+                return false;
+            if (caps)
+                caps->set_tail(topic.substr(pos));
+            return true;
+        }
+
+        if (tf == tfields.end())
+            return false;
+
+        auto field = *tf;
+        if (filt == "+") {
+            if (caps)
+                caps->push(field);
         }
-        if (fields_[i] != "+" && fields_[i] != topic_fields[i]) {
+        else if (filt != field) {
             return false;
         }
+
+        pos += field.size() + 1;
+        ++tf;
     }
 
-    return true;
+    // The whole topic must be used up
+    return tf == tfields.end();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//  						topic_captures
+/////////////////////////////////////////////////////////////////////////////
+
+topic_captures::topic_captures(std::string_view filter, std::string_view topic)
+{
+    auto sep = share_sep(filter);
+    if (sep != string::npos)
+        filter = filter.substr(sep + 1);
+
+    topic_fields tfields{topic};
+    auto tf = tfields.begin();
+    size_t pos = 0;
+
+    for (auto ffield : topic_fields{filter}) {
+        if (tf == tfields.end())
+            break;
+        if (ffield == "#") {
+            set_tail(topic.substr(pos));
+            break;
+        }
+        if (ffield == "+")
+            push(*tf);
+        pos += (*tf).size() + 1;
+        ++tf;
+    }
+}
+
+void topic_captures::push(std::string_view field)
+{
+    if (n_ == MAX_CAPTURES)
+        throw std::length_error("Too many wildcards to capture");
+    fields_[n_++] = field;
 }
 
 /////////////////////////////////////////////////////////////////////////////
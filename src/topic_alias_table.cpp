@@ -0,0 +1,45 @@
+// topic_alias_table.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/topic_alias_table.h"
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint16_t topic_alias_table::find(std::string_view topic) const
+{
+    auto i = topics_.find(topic);
+    return (i != topics_.npos) ? uint16_t(i + 1) : 0;
+}
+
+std::pair<uint16_t, bool> topic_alias_table::assign(const string& topic)
+{
+    if (!enabled())
+        return {0, false};
+
+    auto i = topics_.lookup(topic);
+    if (i != topics_.npos)
+        return {uint16_t(i + 1), false};
+
+    i = topics_.insert(topic);
+    return {uint16_t(i + 1), true};
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
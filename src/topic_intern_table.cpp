@@ -0,0 +1,71 @@
+// topic_intern_table.cpp
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - initial implementation and documentation
+ *******************************************************************************/
+
+#include "mqtt/topic_intern_table.h"
+
+#include <stdexcept>
+
+namespace mqtt {
+
+/////////////////////////////////////////////////////////////////////////////
+
+topic_intern_table::topic_intern_table(size_t capacity) : topics_{capacity}
+{
+    if (capacity == 0)
+        throw std::invalid_argument{"intern table capacity must be non-zero"};
+}
+
+string_ref topic_intern_table::intern(std::string_view topic)
+{
+    auto i = topics_.lookup(topic);
+    if (i != topics_.npos) {
+        ++nHit_;
+        return topics_.key(i);
+    }
+
+    ++nMiss_;
+
+    // The index refers to the shared buffer, which never changes or moves,
+    // even if the slot is later reused while messages still hold it.
+    i = topics_.insert(string_ref{topic.data(), topic.size()});
+    return topics_.key(i);
+}
+
+string_ref topic_intern_table::resolve(std::string_view topic, uint16_t alias)
+{
+    if (alias == 0)
+        return intern(topic);
+
+    if (topic.empty())
+        return alias_topic(alias);
+
+    auto ref = intern(topic);
+    if (alias >= aliases_.size())
+        aliases_.resize(size_t(alias) + 1);
+    aliases_[alias] = ref;
+    return ref;
+}
+
+void topic_intern_table::clear()
+{
+    topics_.clear();
+    aliases_.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+}  // namespace mqtt
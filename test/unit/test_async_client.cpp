@@ -1027,3 +1027,70 @@ TEST_CASE("async_client consumer queue size", "[client]")
     cli.stop_consuming();
     cli.disconnect()->wait();
 }
+
+TEST_CASE("async_client routes", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+
+    cli.add_route("a/+", [](const_message_ptr) {});
+    cli.add_route("b/#", [](const_message_ptr) {}, route_mode::worker);
+
+    REQUIRE(cli.remove_route("a/+"));
+    REQUIRE(!cli.remove_route("a/+"));
+    REQUIRE(!cli.start_route_workers(2));
+
+    REQUIRE_THROWS_AS(cli.add_route("c", nullptr), std::invalid_argument);
+}
+
+TEST_CASE("async_client subscribe route with id", "[client]")
+{
+    async_client cli{
+        GOOD_SERVER_URI, CLIENT_ID, create_options(MQTTVERSION_5), NO_PERSISTENCE
+    };
+
+    properties props{{property::SUBSCRIPTION_IDENTIFIER, 42}};
+    REQUIRE_THROWS_AS(
+        cli.subscribe(TOPIC, GOOD_QOS, [](const_message_ptr) {}, route_mode::direct,
+                      subscribe_options(), props),
+        std::invalid_argument
+    );
+}
+
+TEST_CASE("async_client publish bad topic", "[client]")
+{
+    async_client cli{GOOD_SERVER_URI, CLIENT_ID};
+
+    int reason_code = ReasonCode::SUCCESS;
+    try {
+        cli.publish("bad/+/topic", PAYLOAD);
+    }
+    catch (mqtt::exception& ex) {
+        reason_code = ex.get_reason_code();
+    }
+    REQUIRE(ReasonCode::TOPIC_NAME_INVALID == reason_code);
+}
+
+TEST_CASE("async_client topic aliases", "[client]")
+{
+    async_client cli{
+        GOOD_SERVER_URI, CLIENT_ID, create_options(MQTTVERSION_5), NO_PERSISTENCE
+    };
+
+    REQUIRE(!cli.topic_aliases_enabled());
+
+    cli.enable_topic_aliases(16);
+    REQUIRE(cli.topic_aliases_enabled());
+
+    // Not connected, so the message goes out as it was
+    int return_code = MQTTASYNC_SUCCESS;
+    try {
+        cli.publish(TOPIC, PAYLOAD);
+    }
+    catch (mqtt::exception& ex) {
+        return_code = ex.get_return_code();
+    }
+    REQUIRE(MQTTASYNC_DISCONNECTED == return_code);
+
+    cli.disable_topic_aliases();
+    REQUIRE(!cli.topic_aliases_enabled());
+}
@@ -0,0 +1,95 @@
+// test_clock_index.cpp
+//
+// Unit tests for the clock_index class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ *******************************************************************************/
+
+
+#define UNIT_TESTS
+
+#include "catch2_version.h"
+#include "mqtt/clock_index.h"
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("clock index insert and find", "[clock_index]")
+{
+    clock_index<> idx{4};
+
+    REQUIRE(idx.capacity() == 4);
+    REQUIRE(idx.size() == 0);
+    REQUIRE(idx.find("a") == idx.npos);
+
+    REQUIRE(idx.insert("a") == 0);
+    REQUIRE(idx.insert("b") == 1);
+    REQUIRE(idx.size() == 2);
+
+    REQUIRE(idx.find("b") == 1);
+    REQUIRE(idx.lookup("a") == 0);
+    REQUIRE(idx.key(1) == "b");
+
+    REQUIRE(idx.erase("a"));
+    REQUIRE(!idx.erase("a"));
+    REQUIRE(idx.find("a") == idx.npos);
+    REQUIRE(idx.size() == 1);
+
+    idx.reset(2);
+    REQUIRE(idx.capacity() == 2);
+    REQUIRE(idx.size() == 0);
+}
+
+TEST_CASE("clock index evict", "[clock_index]")
+{
+    clock_index<> idx{3};
+    idx.insert("a");
+    idx.insert("b");
+    idx.insert("c");
+
+    // Each slot was used once, so the hand clears them all, then takes
+    // the first one
+    REQUIRE(idx.insert("d") == 0);
+    REQUIRE(idx.find("a") == idx.npos);
+    REQUIRE(idx.size() == 3);
+
+    // A slot used since the hand passed gets a second chance
+    idx.lookup("b");
+    REQUIRE(idx.insert("e") == 2);
+    REQUIRE(idx.find("b") == 1);
+    REQUIRE(idx.find("c") == idx.npos);
+
+    // A free slot is taken first
+    idx.erase("d");
+    REQUIRE(idx.insert("f") == 0);
+    REQUIRE(idx.find("b") == 1);
+    REQUIRE(idx.find("e") == 2);
+}
+
+TEST_CASE("clock index shared keys", "[clock_index]")
+{
+    clock_index<string_ref> idx{1};
+
+    string_ref a{"a"};
+    REQUIRE(idx.insert(a) == 0);
+    REQUIRE(idx.key(0).ptr() == a.ptr());
+    REQUIRE(idx.find("a") == 0);
+
+    // The evicted key is still valid for anyone that holds it
+    idx.insert(string_ref{"b"});
+    REQUIRE(idx.find("a") == idx.npos);
+    REQUIRE(a.str() == "a");
+}
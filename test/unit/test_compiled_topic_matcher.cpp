@@ -0,0 +1,157 @@
+// test_compiled_topic_matcher.cpp
+//
+// Unit tests for the compiled_topic_matcher class in the Paho MQTT C++
+// library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <algorithm>
+#include <set>
+
+#include "catch2_version.h"
+#include "mqtt/compiled_topic_matcher.h"
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("compiled find", "[compiled_topic_matcher]")
+{
+    compiled_topic_matcher<int> tm{
+        {"some/random/topic", 42}, {"some/#", 99}, {"some/+/topic", 33}, {"some/#", 11}
+    };
+
+    REQUIRE(tm.size() == 3);
+
+    auto it = tm.find("some/random/topic");
+    REQUIRE(it != tm.end());
+    REQUIRE(it->first == "some/random/topic");
+    REQUIRE(it->second == 42);
+
+    // A later duplicate replaces the value
+    REQUIRE(tm.find("some/#")->second == 11);
+    REQUIRE(tm.find("some/+/topic")->second == 33);
+
+    REQUIRE(tm.find("some/random") == tm.end());
+    REQUIRE(tm.find("some/other/topic") == tm.end());
+    REQUIRE(tm.find("#") == tm.end());
+}
+
+TEST_CASE("compiled from topic_matcher", "[compiled_topic_matcher]")
+{
+    topic_matcher<int> dyn{
+        {"some/random/topic", 42},
+        {"some/#", 99},
+        {"some/other/topic", 55},
+        {"some/+/topic", 33}
+    };
+
+    compiled_topic_matcher<int> tm{dyn};
+    REQUIRE(tm.size() == 4);
+
+    auto v = tm.matches("some/random/topic");
+    REQUIRE(v.size() == 3);
+
+    std::set<int> vals;
+    for (const auto* p : v) vals.insert(p->second);
+    REQUIRE(vals == std::set<int>{42, 99, 33});
+
+    // Appends to the output
+    REQUIRE(tm.matches("some/other/topic", v) == 3);
+    REQUIRE(v.size() == 6);
+}
+
+TEST_CASE("compiled rejects shared filters", "[compiled_topic_matcher]")
+{
+    using cmatcher = compiled_topic_matcher<int>;
+    REQUIRE_THROWS_AS((cmatcher{{"a/b", 1}, {"$share/g/#", 2}}), std::invalid_argument);
+
+    topic_matcher<int> dyn{{"a/b", 1}, {"$share/g/#", 2}};
+    REQUIRE_THROWS_AS(cmatcher{dyn}, std::invalid_argument);
+}
+
+// The same corner cases as for the topic_matcher.
+TEST_CASE("compiled matcher matches", "[compiled_topic_matcher]")
+{
+    using tm = compiled_topic_matcher<int>;
+
+    // Should match
+
+    REQUIRE((tm{{"foo/bar", 42}}.has_match("foo/bar")));
+    REQUIRE((tm{{"foo/+", 42}}.has_match("foo/bar")));
+    REQUIRE((tm{{"foo/+/baz", 42}}.has_match("foo/bar/baz")));
+    REQUIRE((tm{{"foo/+/#", 42}}.has_match("foo/bar/baz")));
+    REQUIRE((tm{{"A/B/+/#", 42}}.has_match("A/B/B/C")));
+    REQUIRE((tm{{"#", 42}}.has_match("foo/bar/baz")));
+    REQUIRE((tm{{"#", 42}}.has_match("/foo/bar")));
+    REQUIRE((tm{{"/#", 42}}.has_match("/foo/bar")));
+    REQUIRE((tm{{"$SYS/bar", 42}}.has_match("$SYS/bar")));
+    REQUIRE((tm{{"foo/#", 42}}.has_match("foo/$bar")));
+    REQUIRE((tm{{"foo/+/baz", 42}}.has_match("foo/$bar/baz")));
+    REQUIRE((tm{{"foo//bar", 42}}.has_match("foo//bar")));
+
+    // Should not match
+
+    REQUIRE(!(tm{{"test/6/#", 42}}.has_match("test/3")));
+    REQUIRE(!(tm{{"foo/bar", 42}}.has_match("foo")));
+    REQUIRE(!(tm{{"foo/+", 42}}.has_match("foo/bar/baz")));
+    REQUIRE(!(tm{{"foo/+/baz", 42}}.has_match("foo/bar/bar")));
+    REQUIRE(!(tm{{"foo/+/#", 42}}.has_match("fo2/bar/baz")));
+    REQUIRE(!(tm{{"/#", 42}}.has_match("foo/bar")));
+    REQUIRE(!(tm{{"#", 42}}.has_match("$SYS/bar")));
+    REQUIRE(!(tm{{"$BOB/bar", 42}}.has_match("$SYS/bar")));
+    REQUIRE(!(tm{{"+/bar", 42}}.has_match("$SYS/bar")));
+    REQUIRE(!(tm{{"foo/#/bar", 42}}.has_match("foo/x/bar")));
+}
+
+// Compiled and dynamic matchers should agree on a larger set of filters.
+TEST_CASE("compiled matches dynamic", "[compiled_topic_matcher]")
+{
+    const char* fields[] = {"a", "b", "c", "+"};
+
+    topic_matcher<int> dyn;
+    int n = 0;
+
+    for (auto f1 : fields) {
+        for (auto f2 : fields) {
+            for (auto f3 : fields) {
+                dyn.insert({string{f1} + "/" + f2 + "/" + f3, n++});
+            }
+            dyn.insert({string{f1} + "/" + f2 + "/#", n++});
+        }
+    }
+
+    compiled_topic_matcher<int> tm{dyn};
+
+    for (auto f1 : {"a", "b", "x"}) {
+        for (auto f2 : {"a", "c", "y"}) {
+            for (auto f3 : {"b", "c", "z"}) {
+                auto topic = string{f1} + "/" + f2 + "/" + f3;
+
+                std::vector<int> want, got;
+                for (auto it = dyn.matches(topic); it != dyn.matches_end(); ++it)
+                    want.push_back(it->second);
+                for (auto p : tm.matches(topic)) got.push_back(p->second);
+
+                std::sort(want.begin(), want.end());
+                std::sort(got.begin(), got.end());
+                REQUIRE(want == got);
+            }
+        }
+    }
+}
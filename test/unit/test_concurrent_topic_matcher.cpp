@@ -0,0 +1,164 @@
+// test_concurrent_topic_matcher.cpp
+//
+// Unit tests for the concurrent_topic_matcher class in the Paho MQTT C++
+// library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/concurrent_topic_matcher.h"
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("concurrent insert/remove", "[concurrent_topic_matcher]")
+{
+    concurrent_topic_matcher<int> tm;
+
+    REQUIRE(tm.empty());
+    REQUIRE(tm.version() == 0);
+
+    tm.insert({"some/+/topic", 33});
+    tm.insert({"some/#", 99});
+
+    REQUIRE(!tm.empty());
+    REQUIRE(tm.version() == 2);
+    REQUIRE(tm.has_match("some/random/topic"));
+
+    int sum = 0;
+    auto n = tm.for_each_match("some/random/topic", [&](const auto& val) {
+        sum += val.second;
+    });
+    REQUIRE(n == 2);
+    REQUIRE(sum == 132);
+
+    auto val = tm.remove("some/#");
+    REQUIRE(val);
+    REQUIRE(*val == 99);
+    REQUIRE(!tm.remove("some/#"));
+    REQUIRE(!tm.has_match("some/random"));
+}
+
+TEST_CASE("concurrent snapshot", "[concurrent_topic_matcher]")
+{
+    concurrent_topic_matcher<int> tm{{"a/b", 1}, {"a/+", 2}};
+
+    auto snap = tm.snapshot();
+
+    tm.update([](auto& m) {
+        m.remove("a/b");
+        m.insert({"a/#", 3});
+    });
+
+    // The old snapshot is unchanged
+    REQUIRE(snap->find("a/b") != snap->cend());
+    REQUIRE(!(snap->find("a/#") != snap->cend()));
+
+    auto cur = tm.snapshot();
+    REQUIRE(!(cur->find("a/b") != cur->cend()));
+    REQUIRE(cur->find("a/#") != cur->cend());
+
+    // A failed update leaves the collection alone
+    auto ver = tm.version();
+    try {
+        tm.update([](auto& m) {
+            m.insert({"x/y", 4});
+            throw std::runtime_error("oops");
+        });
+    }
+    catch (const std::runtime_error&) {
+    }
+    REQUIRE(tm.version() == ver);
+    REQUIRE(!tm.has_match("x/y"));
+}
+
+TEST_CASE("concurrent reader", "[concurrent_topic_matcher]")
+{
+    concurrent_topic_matcher<int> tm{{"a/b", 1}};
+
+    auto rdr = tm.get_reader();
+    REQUIRE(rdr.has_match("a/b"));
+    REQUIRE(!rdr.has_match("c/d"));
+
+    tm.insert({"c/+", 2});
+    REQUIRE(rdr.has_match("c/d"));
+
+    int sum = 0;
+    REQUIRE(rdr.for_each_match("c/d", [&](const auto& val) { sum += val.second; }) == 1);
+    REQUIRE(sum == 2);
+}
+
+TEST_CASE("concurrent readers and writer", "[concurrent_topic_matcher]")
+{
+    const int N_READERS = 4, N_WRITES = 100;
+
+    concurrent_topic_matcher<int> tm{{"fixed/#", 1}};
+
+    std::atomic<bool> done{false};
+    std::atomic<bool> ok{true};
+    std::vector<std::thread> readers;
+
+    for (int i = 0; i < N_READERS; ++i) {
+        readers.emplace_back([&] {
+            auto rdr = tm.get_reader();
+            while (!done) {
+                // The fixed filter must always be seen, whatever else changes
+                if (!rdr.has_match("fixed/topic"))
+                    ok = false;
+                rdr.for_each_match("dyn/topic", [&](const auto& val) {
+                    if (val.second < 100)
+                        ok = false;
+                });
+            }
+        });
+    }
+
+    for (int i = 0; i < N_WRITES; ++i) {
+        tm.insert({"dyn/+", 100 + i});
+        if (i % 2)
+            tm.remove("dyn/+");
+    }
+
+    done = true;
+    for (auto& thr : readers) thr.join();
+
+    REQUIRE(ok);
+    REQUIRE(tm.version() == uint64_t(N_WRITES + N_WRITES / 2));
+}
+
+TEST_CASE("concurrent change from match", "[concurrent_topic_matcher]")
+{
+    concurrent_topic_matcher<int> tm{{"a/+", 1}};
+
+    // Changing the collection from a match shouldn't disturb the match
+    size_t n = tm.for_each_match("a/b", [&](const auto& val) {
+        tm.insert({"a/#", val.second + 1});
+        REQUIRE(tm.has_match("a/b"));
+    });
+
+    REQUIRE(n == 1);
+
+    int sum = 0;
+    REQUIRE(tm.for_each_match("a/b", [&](const auto& val) { sum += val.second; }) == 2);
+    REQUIRE(sum == 3);
+}
@@ -0,0 +1,146 @@
+// test_conflating_queue.cpp
+//
+// Unit tests for the conflating queue in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/conflating_queue.h"
+#include "mqtt/consumer_queue.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+static event msg_event(const string& topic, const string& payload)
+{
+    return event{make_message(topic, payload)};
+}
+
+static string payload_of(const event& evt)
+{
+    return (*evt.get_message_if())->to_string();
+}
+
+TEST_CASE("conflating_queue put/get", "[conflating_queue]")
+{
+    conflating_event_queue que;
+
+    que.put(msg_event("a", "1"));
+    que.put(msg_event("b", "1"));
+    REQUIRE(que.size() == 2);
+
+    auto evt = que.get();
+    REQUIRE((*evt.get_message_if())->get_topic() == "a");
+    evt = que.get();
+    REQUIRE((*evt.get_message_if())->get_topic() == "b");
+    REQUIRE(que.empty());
+}
+
+TEST_CASE("conflating_queue latest value wins", "[conflating_queue]")
+{
+    conflating_event_queue que;
+
+    que.put(msg_event("a", "1"));
+    que.put(msg_event("b", "1"));
+    que.put(msg_event("a", "2"));
+    que.put(msg_event("c", "1"));
+    que.put(msg_event("a", "3"));
+    que.put(msg_event("b", "2"));
+
+    // Replaced in place, keeping the original order of the topics
+    REQUIRE(que.size() == 3);
+
+    auto evt = que.get();
+    REQUIRE((*evt.get_message_if())->get_topic() == "a");
+    REQUIRE(payload_of(evt) == "3");
+
+    evt = que.get();
+    REQUIRE((*evt.get_message_if())->get_topic() == "b");
+    REQUIRE(payload_of(evt) == "2");
+
+    // Once delivered, a topic is queued again at the back
+    que.put(msg_event("a", "4"));
+
+    evt = que.get();
+    REQUIRE((*evt.get_message_if())->get_topic() == "c");
+
+    evt = que.get();
+    REQUIRE(payload_of(evt) == "4");
+    REQUIRE(que.empty());
+}
+
+TEST_CASE("conflating_queue control events", "[conflating_queue]")
+{
+    conflating_event_queue que;
+
+    que.put(event{connected_event{}});
+    que.put(msg_event("a", "1"));
+    que.put(event{connection_lost_event{}});
+    que.put(event{connected_event{}});
+    que.put(msg_event("a", "2"));
+
+    REQUIRE(que.size() == 4);
+    REQUIRE(que.get().is_connected());
+
+    auto evt = que.get();
+    REQUIRE(payload_of(evt) == "2");
+
+    REQUIRE(que.get().is_connection_lost());
+    REQUIRE(que.get().is_connected());
+}
+
+TEST_CASE("conflating_deque counts conflated", "[conflating_queue]")
+{
+    conflating_deque<event, event_topic_key> dq;
+
+    event evt = msg_event("a", "1");
+    dq.push_back(std::move(evt));
+
+    // The replaced item is swapped back to the caller
+    evt = msg_event("a", "2");
+    dq.emplace_back(std::move(evt));
+    REQUIRE(payload_of(evt) == "1");
+
+    REQUIRE(dq.size() == 1);
+    REQUIRE(dq.conflated() == 1);
+    REQUIRE(payload_of(dq.front()) == "2");
+
+    dq.pop_front();
+    REQUIRE(dq.empty());
+}
+
+TEST_CASE("conflating_queue as consumer queue", "[conflating_queue]")
+{
+    consumer_queue_ptr que = consumer_queue<conflating_event_queue>::create();
+
+    for (int i = 0; i < 100; ++i) {
+        que->put(msg_event("sensor/1", std::to_string(i)));
+        que->put(msg_event("sensor/2", std::to_string(i)));
+    }
+
+    std::vector<event> evts;
+    REQUIRE(que->try_get_n(evts, 10) == 2);
+    REQUIRE(payload_of(evts[0]) == "99");
+    REQUIRE(payload_of(evts[1]) == "99");
+}
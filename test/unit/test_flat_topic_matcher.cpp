@@ -0,0 +1,175 @@
+// test_flat_topic_matcher.cpp
+//
+// Unit tests for the flat_topic_matcher class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <set>
+
+#include "catch2_version.h"
+#include "mqtt/flat_topic_matcher.h"
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("flat insert/get", "[flat_topic_matcher]")
+{
+    flat_topic_matcher<int> tm;
+    REQUIRE(tm.empty());
+
+    tm.insert({"some/random/topic", 42});
+
+    REQUIRE(!tm.empty());
+    REQUIRE(tm.size() == 1);
+
+    auto it = tm.find("some/random/topic");
+
+    REQUIRE(it != tm.end());
+    REQUIRE(it->first == "some/random/topic");
+    REQUIRE(it->second == 42);
+
+    REQUIRE(!(tm.find("some/random") != tm.end()));
+    REQUIRE(!(tm.find("some/other/topic") != tm.end()));
+
+    // Replace the value
+    tm.insert({"some/random/topic", 99});
+    REQUIRE(tm.size() == 1);
+    REQUIRE(tm.find("some/random/topic")->second == 99);
+}
+
+TEST_CASE("flat rejects shared filters", "[flat_topic_matcher]")
+{
+    flat_topic_matcher<int> tm;
+    REQUIRE_THROWS_AS(tm.insert({"$share/g/#", 1}), std::invalid_argument);
+    REQUIRE(tm.empty());
+
+    // Only a shared subscription prefix is refused
+    tm.insert({"$shared/g/#", 2});
+    REQUIRE(tm.size() == 1);
+}
+
+TEST_CASE("flat remove/prune", "[flat_topic_matcher]")
+{
+    flat_topic_matcher<int> tm{
+        {"some/random/topic", 42}, {"some/#", 99}, {"other/+/topic", 55}
+    };
+
+    REQUIRE(tm.size() == 3);
+
+    auto val = tm.remove("some/random/topic");
+    REQUIRE(val);
+    REQUIRE(*val == 42);
+    REQUIRE(tm.size() == 2);
+    REQUIRE(!tm.has_match("some"));
+    REQUIRE(!tm.remove("some/random/topic"));
+
+    auto nNodes = tm.node_count();
+    auto nFields = tm.field_count();
+
+    tm.prune();
+
+    REQUIRE(tm.size() == 2);
+    REQUIRE(tm.node_count() < nNodes);
+    REQUIRE(tm.field_count() < nFields);
+    REQUIRE(tm.find("some/#")->second == 99);
+    REQUIRE(tm.find("other/+/topic")->second == 55);
+    REQUIRE(tm.has_match("some/random/topic"));
+
+    // The empty slot gets reused
+    tm.insert({"new/topic", 11});
+    tm.remove("new/topic");
+    tm.insert({"newer/topic", 12});
+    REQUIRE(tm.size() == 3);
+}
+
+TEST_CASE("flat iterate", "[flat_topic_matcher]")
+{
+    flat_topic_matcher<int> tm{{"a/b", 1}, {"a/+", 2}, {"#", 3}, {"c", 4}};
+
+    tm.remove("a/+");
+
+    std::set<string> filters;
+    int sum = 0;
+
+    for (const auto& val : tm) {
+        filters.insert(val.first);
+        sum += val.second;
+    }
+
+    REQUIRE(filters == std::set<string>{"a/b", "#", "c"});
+    REQUIRE(sum == 8);
+}
+
+TEST_CASE("flat matcher initialize", "[flat_topic_matcher]")
+{
+    flat_topic_matcher<int> tm{
+        {"some/random/topic", 42},
+        {"some/#", 99},
+        {"some/other/topic", 55},
+        {"some/+/topic", 33}
+    };
+
+    auto it = tm.matches("some/random/topic");
+    int n = 0;
+
+    for (; it != tm.matches_end(); ++it) {
+        bool ok =
+            ((it->first == "some/random/topic" && it->second == 42) ||
+             (it->first == "some/#" && it->second == 99) ||
+             (it->first == "some/+/topic" && it->second == 33));
+        REQUIRE(ok);
+        ++n;
+    }
+    REQUIRE(n == 3);
+}
+
+// The same corner cases as for the topic_matcher.
+TEST_CASE("flat matcher matches", "[flat_topic_matcher]")
+{
+    using tm = flat_topic_matcher<int>;
+
+    // Should match
+
+    REQUIRE((tm{{"foo/bar", 42}}.has_match("foo/bar")));
+    REQUIRE((tm{{"foo/+", 42}}.has_match("foo/bar")));
+    REQUIRE((tm{{"foo/+/baz", 42}}.has_match("foo/bar/baz")));
+    REQUIRE((tm{{"foo/+/#", 42}}.has_match("foo/bar/baz")));
+    REQUIRE((tm{{"A/B/+/#", 42}}.has_match("A/B/B/C")));
+    REQUIRE((tm{{"#", 42}}.has_match("foo/bar/baz")));
+    REQUIRE((tm{{"#", 42}}.has_match("/foo/bar")));
+    REQUIRE((tm{{"/#", 42}}.has_match("/foo/bar")));
+    REQUIRE((tm{{"$SYS/bar", 42}}.has_match("$SYS/bar")));
+    REQUIRE((tm{{"foo/#", 42}}.has_match("foo/$bar")));
+    REQUIRE((tm{{"foo/+/baz", 42}}.has_match("foo/$bar/baz")));
+    REQUIRE((tm{{"foo//bar", 42}}.has_match("foo//bar")));
+    REQUIRE((tm{{"foo/+/bar", 42}}.has_match("foo//bar")));
+
+    // Should not match
+
+    REQUIRE(!(tm{{"test/6/#", 42}}.has_match("test/3")));
+    REQUIRE(!(tm{{"foo/bar", 42}}.has_match("foo")));
+    REQUIRE(!(tm{{"foo/+", 42}}.has_match("foo/bar/baz")));
+    REQUIRE(!(tm{{"foo/+/baz", 42}}.has_match("foo/bar/bar")));
+    REQUIRE(!(tm{{"foo/+/#", 42}}.has_match("fo2/bar/baz")));
+    REQUIRE(!(tm{{"/#", 42}}.has_match("foo/bar")));
+    REQUIRE(!(tm{{"#", 42}}.has_match("$SYS/bar")));
+    REQUIRE(!(tm{{"$BOB/bar", 42}}.has_match("$SYS/bar")));
+    REQUIRE(!(tm{{"+/bar", 42}}.has_match("$SYS/bar")));
+    REQUIRE(!(tm{{"foo/bar", 42}}.has_match("foo/bar/")));
+}
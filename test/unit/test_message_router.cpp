@@ -0,0 +1,277 @@
+// test_message_router.cpp
+//
+// Unit tests for the message_router class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/message_router.h"
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("message_router add/remove", "[router]")
+{
+    message_router rtr;
+
+    REQUIRE(rtr.empty());
+    REQUIRE(!rtr.has_workers());
+
+    rtr.add_route("a/+", [](const_message_ptr) {});
+    rtr.add_route("a/#", [](const_message_ptr) {});
+    REQUIRE(rtr.size() == 2);
+
+    // Replacing a route doesn't add one
+    rtr.add_route("a/#", [](const_message_ptr) {});
+    REQUIRE(rtr.size() == 2);
+
+    REQUIRE(rtr.remove_route("a/+"));
+    REQUIRE(!rtr.remove_route("a/+"));
+    REQUIRE(rtr.size() == 1);
+
+    rtr.clear();
+    REQUIRE(rtr.empty());
+    REQUIRE(rtr.route(make_message("a/b", "x")) == 0);
+
+    REQUIRE_THROWS_AS(rtr.add_route("a/b", nullptr), std::invalid_argument);
+    REQUIRE(!rtr.has_workers());
+}
+
+TEST_CASE("message_router direct", "[router]")
+{
+    message_router rtr;
+    std::multiset<string> got;
+
+    rtr.add_route("a/+", [&](const_message_ptr msg) {
+        got.insert("a/+:" + msg->get_topic());
+    });
+    rtr.add_route("a/#", [&](const_message_ptr msg) {
+        got.insert("a/#:" + msg->get_topic());
+    });
+    rtr.add_route("b/c", [&](const_message_ptr msg) {
+        got.insert("b/c:" + msg->get_topic());
+    });
+
+    REQUIRE(rtr.route(make_message("a/b", "x")) == 2);
+    REQUIRE(rtr.route(make_message("a/b/c", "x")) == 1);
+    REQUIRE(rtr.route(make_message("b/c", "x")) == 1);
+    REQUIRE(rtr.route(make_message("c/d", "x")) == 0);
+
+    REQUIRE(got == std::multiset<string>{"a/+:a/b", "a/#:a/b", "a/#:a/b/c", "b/c:b/c"});
+}
+
+// Makes a message tagged with subscription identifiers
+static const_message_ptr make_tagged_message(
+    const string& topic, std::initializer_list<uint32_t> ids
+)
+{
+    auto msg = make_message(topic, "x");
+    properties props;
+    for (auto id : ids) props.add({property::SUBSCRIPTION_IDENTIFIER, id});
+    msg->set_properties(props);
+    return msg;
+}
+
+TEST_CASE("message_router subscription ids", "[router]")
+{
+    message_router rtr;
+    auto fn = [](const_message_ptr) {};
+
+    REQUIRE(rtr.add_subscription_route("a/+", fn) == 1);
+    REQUIRE(rtr.add_subscription_route("b/#", fn) == 2);
+    REQUIRE(rtr.size() == 2);
+
+    // Replacing the route keeps the id
+    REQUIRE(rtr.add_subscription_route("a/+", fn) == 1);
+    REQUIRE(rtr.subscription_id("a/+") == 1);
+    REQUIRE(rtr.subscription_id("x/y") == 0);
+
+    // A removed id is never reused
+    REQUIRE(rtr.remove_route("a/+"));
+    REQUIRE(rtr.add_subscription_route("c", fn) == 3);
+
+    // A plain route drops the id
+    rtr.add_route("c", fn);
+    REQUIRE(rtr.subscription_id("c") == 0);
+    REQUIRE(rtr.add_subscription_route("d", fn) == 4);
+
+    rtr.clear();
+    REQUIRE(rtr.add_subscription_route("e", fn) == 5);
+}
+
+TEST_CASE("message_router removed id", "[router]")
+{
+    message_router rtr;
+    std::multiset<string> got;
+
+    REQUIRE(rtr.add_subscription_route("a/#", [&](const_message_ptr) { got.insert("a/#"); }) == 1);
+    REQUIRE(rtr.remove_route("a/#"));
+    REQUIRE(rtr.add_subscription_route("b/#", [&](const_message_ptr) { got.insert("b/#"); }) == 2);
+
+    // A message still in flight for the removed subscription goes nowhere
+    REQUIRE(rtr.route(make_tagged_message("a/x", {1})) == 0);
+    REQUIRE(got.empty());
+
+    REQUIRE(rtr.route(make_tagged_message("b/x", {2})) == 1);
+    REQUIRE(got == std::multiset<string>{"b/#"});
+}
+
+TEST_CASE("message_router routes by id", "[router]")
+{
+    message_router rtr;
+    std::multiset<string> got;
+
+    rtr.add_subscription_route("a/+", [&](const_message_ptr) { got.insert("a/+"); });
+    rtr.add_subscription_route("a/#", [&](const_message_ptr) { got.insert("a/#"); });
+
+    // The ids are trusted, without matching the topic
+    REQUIRE(rtr.route(make_tagged_message("x/y", {2})) == 1);
+    REQUIRE(got == std::multiset<string>{"a/#"});
+
+    got.clear();
+    REQUIRE(rtr.route(make_tagged_message("a/b", {1, 2, 99})) == 2);
+    REQUIRE(got == std::multiset<string>{"a/+", "a/#"});
+
+    // Without ids, the topic is matched
+    got.clear();
+    REQUIRE(rtr.route(make_message("a/b", "x")) == 2);
+    REQUIRE(got == std::multiset<string>{"a/+", "a/#"});
+
+    // With a route that has no id, the topic is always matched
+    rtr.add_route("x/#", [&](const_message_ptr) { got.insert("x/#"); });
+
+    got.clear();
+    REQUIRE(rtr.route(make_tagged_message("x/y", {2})) == 1);
+    REQUIRE(got == std::multiset<string>{"x/#"});
+
+    REQUIRE(rtr.remove_route("x/#"));
+
+    got.clear();
+    REQUIRE(rtr.route(make_tagged_message("x/y", {2})) == 1);
+    REQUIRE(got == std::multiset<string>{"a/#"});
+}
+
+TEST_CASE("message_router handler error", "[router]")
+{
+    message_router rtr;
+    int n = 0;
+
+    rtr.add_route("a/+", [](const_message_ptr) { throw std::runtime_error("oops"); });
+    rtr.add_route("a/#", [&](const_message_ptr) { ++n; });
+    rtr.add_route("#", [](const_message_ptr) { throw std::runtime_error("oops"); });
+
+    REQUIRE(rtr.route(make_message("a/b", "x")) == 3);
+    REQUIRE(n == 1);
+}
+
+TEST_CASE("message_router workers", "[router]")
+{
+    const int N_MSGS = 100;
+
+    message_router rtr;
+    REQUIRE(rtr.start_workers(2));
+    REQUIRE(!rtr.start_workers(4));
+    REQUIRE(rtr.has_workers());
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<int> seq;
+    std::thread::id direct, worker;
+
+    rtr.add_route("w/#", [&](const_message_ptr msg) {
+        std::lock_guard<std::mutex> g{mtx};
+        worker = std::this_thread::get_id();
+        seq.push_back(std::stoi(msg->to_string()));
+        cv.notify_all();
+    }, route_mode::worker);
+
+    rtr.add_route("w/+", [&](const_message_ptr) {
+        direct = std::this_thread::get_id();
+    });
+
+    for (int i = 0; i < N_MSGS; ++i)
+        REQUIRE(rtr.route(make_message("w/x", std::to_string(i))) == 2);
+
+    std::unique_lock<std::mutex> lk{mtx};
+    REQUIRE(cv.wait_for(lk, std::chrono::seconds(5), [&] { return seq.size() == N_MSGS; }));
+
+    // The messages for a topic are handled in order, off the routing thread
+    for (int i = 0; i < N_MSGS; ++i) REQUIRE(seq[i] == i);
+
+    REQUIRE(direct == std::this_thread::get_id());
+    REQUIRE(worker != std::this_thread::get_id());
+}
+
+TEST_CASE("message_router starts workers", "[router]")
+{
+    message_router rtr;
+    rtr.add_route("a", [](const_message_ptr) {}, route_mode::worker);
+    REQUIRE(rtr.has_workers());
+}
+
+TEST_CASE("message_router workers use the routes at routing", "[router]")
+{
+    message_router rtr;
+    REQUIRE(rtr.start_workers(1));
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool release = false;
+    std::vector<string> got;
+
+    // Holds the single worker until the routes are changed
+    rtr.add_route("block", [&](const_message_ptr) {
+        std::unique_lock<std::mutex> lk{mtx};
+        cv.wait(lk, [&] { return release; });
+    }, route_mode::worker);
+
+    auto handler = [&](const string& name) {
+        return [&, name](const_message_ptr msg) {
+            std::lock_guard<std::mutex> g{mtx};
+            got.push_back(name + ":" + msg->get_topic());
+            cv.notify_all();
+        };
+    };
+
+    rtr.add_route("a/#", handler("old"), route_mode::worker);
+    rtr.add_route("b/#", handler("gone"), route_mode::worker);
+
+    REQUIRE(rtr.route(make_message("block", "")) == 1);
+    REQUIRE(rtr.route(make_message("a/x", "")) == 1);
+    REQUIRE(rtr.route(make_message("b/x", "")) == 1);
+
+    // Change the routes while the messages are queued
+    rtr.add_route("a/#", handler("new"), route_mode::worker);
+    REQUIRE(rtr.remove_route("b/#"));
+    rtr.add_route("+/x", handler("added"), route_mode::worker);
+
+    std::unique_lock<std::mutex> lk{mtx};
+    release = true;
+    cv.notify_all();
+    REQUIRE(cv.wait_for(lk, std::chrono::seconds(5), [&] { return got.size() == 2; }));
+
+    // Each message went to exactly the handlers that it matched when routed
+    REQUIRE(got == std::vector<string>{"old:a/x", "gone:b/x"});
+}
@@ -0,0 +1,150 @@
+// test_rcu_ptr.cpp
+//
+// Unit tests for the rcu_ptr class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/rcu_ptr.h"
+
+using namespace mqtt;
+
+// A value that tracks whether it's still alive
+struct tracked
+{
+    int val;
+    std::shared_ptr<int> life;
+    tracked(int v) : val{v}, life{std::make_shared<int>(v)} {}
+};
+
+using tracked_ptr = std::shared_ptr<const tracked>;
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("rcu_ptr load and store", "[rcu_ptr]")
+{
+    rcu_ptr<int> p{std::make_shared<const int>(1)};
+    REQUIRE(p.version() == 0);
+    REQUIRE(*p.load() == 1);
+    REQUIRE(p.with_local([](const int& v) { return v; }) == 1);
+
+    p.store(std::make_shared<const int>(2));
+    REQUIRE(p.version() == 1);
+    REQUIRE(*p.load() == 2);
+    REQUIRE(p.with_local([](const int& v) { return v; }) == 2);
+}
+
+TEST_CASE("rcu_ptr many pointers on a thread", "[rcu_ptr]")
+{
+    const int N = 16;
+    std::vector<std::unique_ptr<rcu_ptr<int>>> ptrs;
+    for (int i = 0; i < N; ++i)
+        ptrs.emplace_back(new rcu_ptr<int>{std::make_shared<const int>(i)});
+
+    for (int n = 0; n < 3; ++n) {
+        for (int i = 0; i < N; ++i) {
+            auto v = ptrs[i]->with_local([](const int& v) { return v; });
+            REQUIRE(v == i + n * N);
+            ptrs[i]->store(std::make_shared<const int>(v + N));
+        }
+    }
+}
+
+TEST_CASE("rcu_ptr nested read", "[rcu_ptr]")
+{
+    rcu_ptr<int> p{std::make_shared<const int>(1)};
+
+    p.with_local([&](const int& outer) {
+        p.store(std::make_shared<const int>(2));
+        // The inner read gets the new value, the outer keeps the old one
+        REQUIRE(p.with_local([](const int& v) { return v; }) == 2);
+        REQUIRE(outer == 1);
+        return 0;
+    });
+    REQUIRE(p.with_local([](const int& v) { return v; }) == 2);
+}
+
+TEST_CASE("rcu_ptr releases copies on destruction", "[rcu_ptr]")
+{
+    auto p = std::make_unique<rcu_ptr<tracked>>(std::make_shared<const tracked>(1));
+    std::weak_ptr<int> life = p->load()->life;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool haveRead = false, done = false;
+
+    // A thread that reads the pointer, then stays alive
+    std::thread thr([&] {
+        p->with_local([](const tracked& t) { return t.val; });
+        std::unique_lock<std::mutex> g{mtx};
+        haveRead = true;
+        cv.notify_all();
+        cv.wait(g, [&] { return done; });
+    });
+
+    {
+        std::unique_lock<std::mutex> g{mtx};
+        cv.wait(g, [&] { return haveRead; });
+    }
+
+    p.reset();
+    bool expired = life.expired();
+
+    {
+        std::lock_guard<std::mutex> g{mtx};
+        done = true;
+        cv.notify_all();
+    }
+    thr.join();
+
+    REQUIRE(expired);
+}
+
+TEST_CASE("rcu_ptr releases copies on thread exit", "[rcu_ptr]")
+{
+    rcu_ptr<tracked> p{std::make_shared<const tracked>(1)};
+    std::weak_ptr<int> life = p.load()->life;
+
+    std::thread thr([&] { p.with_local([](const tracked& t) { return t.val; }); });
+    thr.join();
+
+    // Only the thread's cached copy would be keeping the old value alive
+    p.store(std::make_shared<const tracked>(2));
+    REQUIRE(life.expired());
+}
+
+TEST_CASE("rcu_ptr destroyed from a reader", "[rcu_ptr]")
+{
+    auto p = std::make_unique<rcu_ptr<tracked>>(std::make_shared<const tracked>(1));
+    std::weak_ptr<int> life = p->load()->life;
+
+    auto v = p->with_local([&](const tracked& t) {
+        p.reset();
+        // The value stays alive until the reader is done with it
+        return *t.life;
+    });
+
+    REQUIRE(v == 1);
+    REQUIRE(life.expired());
+}
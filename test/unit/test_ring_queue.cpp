@@ -0,0 +1,276 @@
+// test_ring_queue.cpp
+//
+// Unit tests for the ring_queue class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/consumer_queue.h"
+#include "mqtt/ring_queue.h"
+#include "mqtt/types.h"
+
+using namespace mqtt;
+using namespace std::chrono;
+
+TEST_CASE("ring_queue capacity", "[ring_queue]")
+{
+    REQUIRE(ring_queue<int>{}.capacity() == ring_queue<int>::DFLT_CAPACITY);
+    REQUIRE(ring_queue<int>{1}.capacity() == 2);
+    REQUIRE(ring_queue<int>{8}.capacity() == 8);
+    REQUIRE(ring_queue<int>{100}.capacity() == 128);
+}
+
+TEST_CASE("ring_queue put/get", "[ring_queue]")
+{
+    ring_queue<int> que;
+
+    REQUIRE(que.empty());
+
+    que.put(1);
+    que.put(2);
+    REQUIRE(que.size() == 2);
+    REQUIRE(que.get() == 1);
+
+    que.put(3);
+    REQUIRE(que.get() == 2);
+    REQUIRE(que.get() == 3);
+    REQUIRE(que.empty());
+}
+
+TEST_CASE("ring_queue tryget", "[ring_queue]")
+{
+    ring_queue<int> que;
+    int n;
+
+    // try_get's should fail on empty queue
+    REQUIRE(!que.try_get(&n));
+    REQUIRE(!que.try_get_for(&n, 5ms));
+
+    auto timeout = steady_clock::now() + 15ms;
+    REQUIRE(!que.try_get_until(&n, timeout));
+
+    que.put(1);
+    que.put(2);
+    REQUIRE(que.try_get(&n));
+    REQUIRE(n == 1);
+
+    que.put(3);
+    REQUIRE(que.try_get(&n));
+    REQUIRE(n == 2);
+    REQUIRE(que.try_get(&n));
+    REQUIRE(n == 3);
+
+    // Empty now. Try should fail and leave 'n' unchanged
+    REQUIRE(!que.try_get(&n));
+    REQUIRE(n == 3);
+}
+
+TEST_CASE("ring_queue tryput", "[ring_queue]")
+{
+    ring_queue<int> que{2};
+
+    REQUIRE(que.try_put(1));
+    REQUIRE(que.try_put(2));
+
+    // Queue full. Put should fail
+    REQUIRE(!que.try_put(3));
+    REQUIRE(!que.try_put_for(3, 5ms));
+
+    auto timeout = steady_clock::now() + 15ms;
+    REQUIRE(!que.try_put_until(3, timeout));
+
+    // Wraps around after an item is removed
+    REQUIRE(que.get() == 1);
+    REQUIRE(que.try_put(3));
+    REQUIRE(que.get() == 2);
+    REQUIRE(que.get() == 3);
+}
+
+TEST_CASE("ring_queue put blocks when full", "[ring_queue]")
+{
+    ring_queue<int> que{2};
+    que.put(1);
+    que.put(2);
+
+    auto thr = std::thread([&que] {
+        std::this_thread::sleep_for(10ms);
+        que.get();
+    });
+
+    // Should block until the other thread makes room
+    que.put(3);
+    thr.join();
+
+    REQUIRE(que.get() == 2);
+    REQUIRE(que.get() == 3);
+}
+
+TEST_CASE("ring_queue mt put/get", "[ring_queue]")
+{
+    ring_queue<size_t> que{64};
+    const size_t N = 100000;
+    const size_t N_THR = 2;
+
+    auto producer = [&que, &N]() {
+        for (size_t i = 0; i < N; ++i) {
+            que.put(i);
+        }
+    };
+
+    auto consumer = [&que, &N]() {
+        size_t n, sum = 0;
+        for (size_t i = 0; i < N; ++i) {
+            if (!que.try_get_for(&n, 250ms))
+                return size_t(0);
+            sum += n;
+        }
+        return sum;
+    };
+
+    std::vector<std::thread> producers;
+    std::vector<std::future<size_t>> consumers;
+
+    for (size_t i = 0; i < N_THR; ++i) {
+        producers.push_back(std::thread(producer));
+    }
+
+    for (size_t i = 0; i < N_THR; ++i) {
+        consumers.push_back(std::async(std::launch::async, consumer));
+    }
+
+    for (size_t i = 0; i < N_THR; ++i) {
+        producers[i].join();
+    }
+
+    // Every item should come out exactly once
+    size_t sum = 0;
+    for (size_t i = 0; i < N_THR; ++i) {
+        sum += consumers[i].get();
+    }
+    REQUIRE(sum == N_THR * (N * (N - 1) / 2));
+    REQUIRE(que.empty());
+}
+
+TEST_CASE("ring_queue close", "[ring_queue]")
+{
+    ring_queue<int> que;
+    REQUIRE(!que.closed());
+
+    que.put(1);
+    que.put(2);
+    que.close();
+
+    // Queue is closed. Shouldn't accept any new items.
+    REQUIRE(que.closed());
+    REQUIRE(que.size() == 2);
+
+    REQUIRE_THROWS_AS(que.put(3), queue_closed);
+    REQUIRE(!que.try_put(3));
+    REQUIRE(!que.try_put_for(3, 10ms));
+    REQUIRE(!que.try_put_until(3, steady_clock::now() + 10ms));
+
+    // But can get any items already in there.
+    REQUIRE(!que.done());
+    REQUIRE(que.get() == 1);
+    REQUIRE(que.get() == 2);
+
+    // When done (closed and empty), should throw on a get(),
+    // or fail on a try_get
+    REQUIRE(que.empty());
+    REQUIRE(que.done());
+
+    int n;
+    REQUIRE_THROWS_AS(que.get(), queue_closed);
+    REQUIRE(!que.try_get(&n));
+    REQUIRE(!que.try_get_for(&n, 10ms));
+    REQUIRE(!que.try_get_until(&n, steady_clock::now() + 10ms));
+}
+
+TEST_CASE("ring_queue close_signals", "[ring_queue]")
+{
+    ring_queue<int> que;
+    REQUIRE(!que.closed());
+
+    auto thr = std::thread([&que] {
+        std::this_thread::sleep_for(10ms);
+        que.close();
+    });
+
+    // Should initially block, but then throw when the queue
+    // is closed by the other thread.
+    REQUIRE_THROWS_AS(que.get(), queue_closed);
+
+    thr.join();
+}
+
+TEST_CASE("ring_queue as consumer queue", "[ring_queue]")
+{
+    consumer_queue_ptr que = consumer_queue<ring_queue<event>>::create(4);
+    REQUIRE(que->capacity() == 4);
+
+    que->put(event{connected_event{"up"}});
+    REQUIRE(que->size() == 1);
+
+    event evt;
+    REQUIRE(que->try_get_for(&evt, 10ms));
+    REQUIRE(evt.is_connected());
+    REQUIRE(!que->try_get_until(&evt, steady_clock::now() + 5ms));
+
+    que->close();
+    REQUIRE(que->done());
+}
+
+TEST_CASE("ring_queue get_n", "[ring_queue]")
+{
+    ring_queue<int> que{8};
+    std::vector<int> vec;
+
+    REQUIRE(que.try_get_n(vec, 4) == 0);
+    REQUIRE(que.try_get_n_for(vec, 4, 10ms) == 0);
+
+    for (int i = 1; i <= 6; ++i) que.put(i);
+
+    REQUIRE(que.get_n(vec, 0) == 0);
+    REQUIRE(que.get_n(vec, 4) == 4);
+    REQUIRE(que.try_get_n(vec, 4) == 2);
+    REQUIRE(vec == std::vector<int>{1, 2, 3, 4, 5, 6});
+
+    que.close();
+    REQUIRE(que.get_n(vec, 4) == 0);
+}
+
+TEST_CASE("ring_queue consumer queue get_n", "[ring_queue]")
+{
+    consumer_queue_ptr que = consumer_queue<ring_queue<event>>::create(4);
+    std::vector<event> evts;
+
+    que->put(event{connected_event{"up"}});
+    que->put(event{connection_lost_event{"down"}});
+
+    REQUIRE(que->try_get_n_for(evts, 8, 10ms) == 2);
+    REQUIRE(evts[0].is_connected());
+    REQUIRE(evts[1].is_connection_lost());
+    REQUIRE(que->try_get_n_until(evts, 8, steady_clock::now() + 5ms) == 0);
+}
@@ -0,0 +1,134 @@
+// test_sharded_dispatcher.cpp
+//
+// Unit tests for the sharded_dispatcher class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Frank Pagliughi - Initial implementation
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "catch2_version.h"
+#include "mqtt/sharded_dispatcher.h"
+
+using namespace mqtt;
+
+TEST_CASE("sharded_dispatcher workers", "[dispatcher]")
+{
+    sharded_dispatcher disp{0, [](const_message_ptr) {}};
+    REQUIRE(disp.size() == 1);
+
+    REQUIRE_THROWS_AS(sharded_dispatcher(2, nullptr), std::invalid_argument);
+}
+
+TEST_CASE("sharded_dispatcher same topic same worker", "[dispatcher]")
+{
+    sharded_dispatcher disp{4, [](const_message_ptr) {}};
+
+    auto msg1 = make_message("a/b", "1");
+    auto msg2 = make_message("a/b", "2");
+
+    REQUIRE(disp.shard_of(*msg1) == disp.shard_of(*msg2));
+    REQUIRE(disp.shard_of(*msg1) < 4);
+}
+
+TEST_CASE("sharded_dispatcher preserves order per key", "[dispatcher]")
+{
+    const int N_TOPICS = 8, N_MSGS = 500;
+
+    std::mutex mtx;
+    std::map<string, std::vector<int>> received;
+    std::set<std::thread::id> threads;
+
+    sharded_dispatcher disp{4, [&](const_message_ptr msg) {
+                                std::lock_guard<std::mutex> g{mtx};
+                                received[msg->get_topic()].push_back(std::stoi(msg->to_string()));
+                                threads.insert(std::this_thread::get_id());
+                            }};
+
+    for (int i = 0; i < N_MSGS; ++i) {
+        for (int t = 0; t < N_TOPICS; ++t)
+            disp.dispatch(make_message("topic/" + std::to_string(t), std::to_string(i)));
+    }
+
+    // Stopping drains the queued messages
+    disp.stop();
+
+    REQUIRE(received.size() == size_t(N_TOPICS));
+    for (auto& r : received) {
+        REQUIRE(r.second.size() == size_t(N_MSGS));
+        for (int i = 0; i < N_MSGS; ++i) REQUIRE(r.second[i] == i);
+    }
+    REQUIRE(threads.size() <= 4);
+    REQUIRE_THROWS_AS(disp.dispatch(make_message("topic/0", "x")), queue_closed);
+}
+
+TEST_CASE("sharded_dispatcher user key", "[dispatcher]")
+{
+    std::atomic<int> n{0};
+
+    dispatch_options opts;
+    opts.key = [](const message& msg) { return std::size_t(msg.get_qos()); };
+    opts.threadName = "mqtt-worker-";
+    opts.cpus = {0};
+
+    sharded_dispatcher disp{3, [&](const_message_ptr) { ++n; }, opts};
+
+    REQUIRE(disp.shard_of(*make_message("a", "x", 0, false)) == 0);
+    REQUIRE(disp.shard_of(*make_message("b", "x", 1, false)) == 1);
+    REQUIRE(disp.shard_of(*make_message("c", "x", 2, false)) == 2);
+
+    disp.dispatch(make_message("a", "x"));
+    disp.stop();
+    REQUIRE(n == 1);
+}
+
+TEST_CASE("sharded_dispatcher stop from handler", "[dispatcher]")
+{
+    std::atomic<int> n{0};
+    std::promise<void> stopped;
+    auto fut = stopped.get_future();
+
+    sharded_dispatcher* pdisp = nullptr;
+
+    auto disp = std::make_unique<sharded_dispatcher>(2, [&](const_message_ptr) {
+        ++n;
+        pdisp->stop();
+        stopped.set_value();
+        // Keep running a while after the stop, so that the destructor has
+        // to wait for this worker.
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ++n;
+    });
+    pdisp = disp.get();
+
+    disp->dispatch(make_message("topic", "x"));
+    fut.wait();
+
+    // Destroying it joins the worker that stopped it
+    disp.reset();
+    REQUIRE(n == 2);
+}
@@ -26,7 +26,12 @@
 #include <thread>
 #include <vector>
 
+#if defined(__linux__)
+    #include <poll.h>
+#endif
+
 #include "catch2_version.h"
+#include "mqtt/consumer_queue.h"
 #include "mqtt/thread_queue.h"
 #include "mqtt/types.h"
 
@@ -185,3 +190,529 @@ TEST_CASE("thread_queue close_signals", "[thread_queue]")
 
     thr.join();
 }
+
+TEST_CASE("thread_queue get_n", "[thread_queue]")
+{
+    thread_queue<int> que;
+    std::vector<int> vec;
+
+    REQUIRE(que.try_get_n(vec, 4) == 0);
+    REQUIRE(que.try_get_n_for(vec, 4, 10ms) == 0);
+    REQUIRE(vec.empty());
+
+    for (int i = 1; i <= 6; ++i) que.put(i);
+
+    REQUIRE(que.get_n(vec, 0) == 0);
+    REQUIRE(que.get_n(vec, 4) == 4);
+    REQUIRE(vec == std::vector<int>{1, 2, 3, 4});
+
+    // Appends to the vector, and only gets what's available
+    REQUIRE(que.try_get_n(vec, 4) == 2);
+    REQUIRE(vec == std::vector<int>{1, 2, 3, 4, 5, 6});
+    REQUIRE(que.empty());
+}
+
+TEST_CASE("thread_queue get_n blocking", "[thread_queue]")
+{
+    thread_queue<int> que;
+    std::vector<int> vec;
+
+    auto thr = std::thread([&que] {
+        std::this_thread::sleep_for(10ms);
+        que.put(42);
+        std::this_thread::sleep_for(10ms);
+        que.close();
+    });
+
+    REQUIRE(que.get_n(vec, 8) == 1);
+    REQUIRE(vec[0] == 42);
+
+    // Returns zero once the queue is closed and empty
+    REQUIRE(que.get_n(vec, 8) == 0);
+    thr.join();
+}
+
+TEST_CASE("thread_queue get_n unblocks putters", "[thread_queue]")
+{
+    const size_t CAP = 2;
+    thread_queue<int> que{CAP};
+    std::vector<int> vec;
+
+    que.put(1);
+    que.put(2);
+
+    auto thr = std::thread([&que] {
+        que.put(3);
+        que.put(4);
+    });
+
+    REQUIRE(que.try_get_n_for(vec, 2, 100ms) == 2);
+    while (vec.size() < 4) {
+        REQUIRE(que.try_get_n_for(vec, 2, 100ms) > 0);
+    }
+    thr.join();
+    REQUIRE(vec == std::vector<int>{1, 2, 3, 4});
+}
+
+TEST_CASE("thread_queue overflow drop_oldest", "[thread_queue]")
+{
+    thread_queue<int> que{2, overflow_policy::drop_oldest};
+    REQUIRE(que.overflow() == overflow_policy::drop_oldest);
+
+    que.put(1);
+    que.put(2);
+    que.put(3);
+    que.put(4);
+
+    REQUIRE(que.size() == 2);
+    REQUIRE(que.dropped() == 2);
+    REQUIRE(que.get() == 3);
+    REQUIRE(que.get() == 4);
+
+    // try_put() doesn't apply the policy
+    que.put(5);
+    que.put(6);
+    REQUIRE(!que.try_put(7));
+    REQUIRE(que.dropped() == 2);
+}
+
+TEST_CASE("thread_queue overflow drop_newest", "[thread_queue]")
+{
+    thread_queue<int> que{2, overflow_policy::drop_newest};
+
+    que.put(1);
+    que.put(2);
+    que.put(3);
+
+    REQUIRE(que.size() == 2);
+    REQUIRE(que.dropped() == 1);
+    REQUIRE(que.get() == 1);
+    REQUIRE(que.get() == 2);
+
+    que.close();
+    REQUIRE_THROWS_AS(que.put(4), queue_closed);
+}
+
+TEST_CASE("thread_queue overflow block_with_deadline", "[thread_queue]")
+{
+    thread_queue<int> que{1, overflow_policy::block_with_deadline, 10ms};
+    que.put(1);
+
+    // Times out and drops the new item
+    auto start = steady_clock::now();
+    que.put(2);
+    REQUIRE(steady_clock::now() - start >= 10ms);
+    REQUIRE(que.dropped() == 1);
+
+    // Gets in if space is made before the deadline
+    que.overflow(overflow_policy::block_with_deadline, 5s);
+    auto thr = std::thread([&que] {
+        std::this_thread::sleep_for(10ms);
+        que.get();
+    });
+
+    que.put(3);
+    thr.join();
+
+    REQUIRE(que.dropped() == 1);
+    REQUIRE(que.get() == 3);
+}
+
+TEST_CASE("thread_queue priority lane", "[thread_queue]")
+{
+    thread_queue<int> que{2};
+
+    que.put(1);
+    que.put(2);
+
+    // The priority lane ignores the capacity
+    que.put_priority(10);
+    que.put_priority(11);
+    REQUIRE(que.size() == 4);
+    REQUIRE(que.priority_size() == 2);
+    REQUIRE(!que.try_put(3));
+
+    REQUIRE(que.get() == 10);
+    REQUIRE(que.get() == 11);
+    REQUIRE(que.priority_size() == 0);
+
+    std::vector<int> vec;
+    que.put_priority(12);
+    REQUIRE(que.get_n(vec, 8) == 3);
+    REQUIRE(vec == std::vector<int>{12, 1, 2});
+
+    que.close();
+    REQUIRE_THROWS_AS(que.put_priority(13), queue_closed);
+}
+
+TEST_CASE("thread_queue priority consumer queue", "[thread_queue]")
+{
+    auto que = priority_consumer_queue<>::create();
+
+    que->put(event{make_message("a", "1")});
+    que->put(event{make_message("a", "2")});
+    que->put_control(event{connection_lost_event{}});
+
+    REQUIRE(que->get().is_connection_lost());
+    REQUIRE(que->get().is_message());
+
+    // The plain adapter keeps control events in order
+    que = consumer_queue<>::create();
+    que->put(event{make_message("a", "1")});
+    que->put_control(event{connection_lost_event{}});
+
+    REQUIRE(que->get().is_message());
+    REQUIRE(que->get().is_connection_lost());
+}
+
+TEST_CASE("thread_queue control events bypass overflow", "[thread_queue]")
+{
+    // A full queue that drops new items still takes the control events
+    auto que = consumer_queue<>::create(2, overflow_policy::drop_newest);
+    que->put(event{make_message("a", "1")});
+    que->put(event{make_message("a", "2")});
+    que->put(event{make_message("a", "3")});
+    que->put_control(event{disconnected_event{}});
+
+    REQUIRE(que->size() == 3);
+    REQUIRE(que->dropped() == 1);
+    REQUIRE(que->get().get_message()->to_string() == "1");
+    REQUIRE(que->get().get_message()->to_string() == "2");
+    REQUIRE(que->get().is_disconnected());
+
+    // ...and one that drops old items doesn't make room for them
+    que = consumer_queue<>::create(2, overflow_policy::drop_oldest);
+    que->put(event{make_message("a", "1")});
+    que->put(event{make_message("a", "2")});
+    que->put_control(event{connection_lost_event{}});
+
+    REQUIRE(que->dropped() == 0);
+    REQUIRE(que->get().is_message());
+    REQUIRE(que->get().is_message());
+    REQUIRE(que->get().is_connection_lost());
+
+    que->close();
+    REQUIRE_THROWS_AS(que->put_control(event{connected_event{}}), queue_closed);
+}
+
+#if defined(__linux__)
+
+static bool is_readable(int fd)
+{
+    pollfd pfd{fd, POLLIN, 0};
+    return ::poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+}
+
+TEST_CASE("thread_queue notify_fd", "[thread_queue]")
+{
+    thread_queue<int> que;
+    que.put(1);
+
+    // Readable if created with items already in the queue
+    int fd = que.notify_fd();
+    REQUIRE(fd >= 0);
+    REQUIRE(que.notify_fd() == fd);
+    REQUIRE(is_readable(fd));
+
+    REQUIRE(que.get() == 1);
+    REQUIRE(!is_readable(fd));
+
+    que.put(2);
+    que.put(3);
+    REQUIRE(is_readable(fd));
+
+    std::vector<int> vec;
+    REQUIRE(que.try_get_n(vec, 1) == 1);
+    REQUIRE(is_readable(fd));
+    REQUIRE(que.try_get_n(vec, 8) == 1);
+    REQUIRE(!is_readable(fd));
+
+    que.put_priority(4);
+    REQUIRE(is_readable(fd));
+    que.clear();
+    REQUIRE(!is_readable(fd));
+
+    // Stays readable once closed
+    que.close();
+    REQUIRE(is_readable(fd));
+}
+
+TEST_CASE("thread_queue consumer notify_fd", "[thread_queue]")
+{
+    auto que = consumer_queue<>::create();
+    int fd = que->notify_fd();
+    REQUIRE(fd >= 0);
+    REQUIRE(!is_readable(fd));
+
+    que->put_control(event{connected_event{}});
+    REQUIRE(is_readable(fd));
+}
+
+#endif
+
+TEST_CASE("thread_queue spin budget", "[thread_queue]")
+{
+    thread_queue<int> que{4};
+    REQUIRE(que.spin_budget() == 0);
+
+    que.spin_budget(1000, 4);
+    REQUIRE(que.spin_budget() == 1000);
+
+    // Spinning consumer and producer, bounded to force waits both ways
+    const int N = 10000;
+    auto thr = std::thread([&que] {
+        for (int i = 0; i < N; ++i) que.put(i);
+    });
+
+    for (int i = 0; i < N; ++i) REQUIRE(que.get() == i);
+    thr.join();
+
+    // Still sleeps and wakes on close once the budget runs out
+    auto closer = std::thread([&que] {
+        std::this_thread::sleep_for(10ms);
+        que.close();
+    });
+    REQUIRE_THROWS_AS(que.get(), queue_closed);
+    closer.join();
+}
+
+TEST_CASE("thread_queue spinning put stops on close", "[thread_queue]")
+{
+    thread_queue<int> que{1};
+    que.put(0);
+
+    // A budget long enough that the put would stall if it ignored the close
+    que.spin_budget(2'000'000'000u);
+
+    auto closer = std::thread([&que] {
+        std::this_thread::sleep_for(10ms);
+        que.close();
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    bool threw = false;
+    try {
+        que.put(1);
+    }
+    catch (const queue_closed&) {
+        threw = true;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    closer.join();
+
+    REQUIRE(threw);
+    REQUIRE(elapsed < 1s);
+}
+
+TEST_CASE("thread_queue spinning get stops on close", "[thread_queue]")
+{
+    thread_queue<int> que;
+
+    // A budget long enough that the get would stall if it ignored the close
+    que.spin_budget(2'000'000'000u);
+
+    auto closer = std::thread([&que] {
+        std::this_thread::sleep_for(10ms);
+        que.close();
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    bool threw = false;
+    try {
+        que.get();
+    }
+    catch (const queue_closed&) {
+        threw = true;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    closer.join();
+
+    REQUIRE(threw);
+    REQUIRE(elapsed < 1s);
+}
+
+TEST_CASE("thread_queue byte capacity", "[thread_queue]")
+{
+    thread_queue<string> que;
+    REQUIRE(que.size_bytes() == 0);
+
+    que.byte_capacity(10, [](const string& s) { return s.size(); });
+    REQUIRE(que.byte_capacity() == 10);
+
+    REQUIRE(que.try_put("abcd"));
+    REQUIRE(que.try_put("efgh"));
+    REQUIRE(que.size_bytes() == 8);
+
+    // Over budget
+    REQUIRE(!que.try_put("ijk"));
+    REQUIRE(!que.try_put_for("ijk", 5ms));
+    REQUIRE(que.try_put("ij"));
+    REQUIRE(que.size_bytes() == 10);
+
+    REQUIRE(que.get() == "abcd");
+    REQUIRE(que.size_bytes() == 6);
+
+    std::vector<string> vec;
+    REQUIRE(que.try_get_n(vec, 8) == 2);
+    REQUIRE(que.size_bytes() == 0);
+
+    // An oversized item still fits in an empty queue
+    REQUIRE(que.try_put("0123456789abcdef"));
+    REQUIRE(!que.try_put("x"));
+}
+
+TEST_CASE("thread_queue byte capacity blocks", "[thread_queue]")
+{
+    thread_queue<string> que;
+    que.byte_capacity(8, [](const string& s) { return s.size(); });
+
+    que.put("12345678");
+
+    auto thr = std::thread([&que] {
+        std::this_thread::sleep_for(10ms);
+        que.get();
+    });
+
+    // Blocks until the first is removed
+    que.put("abc");
+    thr.join();
+
+    REQUIRE(que.size() == 1);
+    REQUIRE(que.size_bytes() == 3);
+}
+
+TEST_CASE("thread_queue byte capacity priority", "[thread_queue]")
+{
+    auto blocked_put = [](bool batch) {
+        thread_queue<string> que;
+        que.byte_capacity(8, [](const string& s) { return s.size(); });
+
+        // The priority item holds most of the budget
+        que.put("1");
+        que.put_priority("1234567");
+
+        auto thr = std::thread([&que, batch] {
+            std::this_thread::sleep_for(10ms);
+            if (batch) {
+                std::vector<string> vec;
+                que.get_n(vec, 1);
+            }
+            else
+                que.get();
+        });
+
+        // Removing the priority item must wake the blocked put. If it
+        // doesn't, this only gets in when the wait times out.
+        auto start = steady_clock::now();
+        bool ok = que.try_put_for("abc", 5s);
+        auto elapsed = steady_clock::now() - start;
+        thr.join();
+
+        REQUIRE(ok);
+        REQUIRE(elapsed < 2s);
+        REQUIRE(que.size_bytes() == 4);
+    };
+
+    blocked_put(false);
+    blocked_put(true);
+}
+
+TEST_CASE("thread_queue byte capacity drop_oldest", "[thread_queue]")
+{
+    thread_queue<string> que{100, overflow_policy::drop_oldest};
+    que.put("abc");
+    que.put("defg");
+
+    // Counts what's already in the queue
+    que.byte_capacity(8, [](const string& s) { return s.size(); });
+    REQUIRE(que.size_bytes() == 7);
+
+    que.put("hijkl");
+    REQUIRE(que.dropped() == 2);
+    REQUIRE(que.size_bytes() == 5);
+    REQUIRE(que.get() == "hijkl");
+}
+
+TEST_CASE("thread_queue event bytes", "[thread_queue]")
+{
+    thread_queue<event> que;
+    que.byte_capacity(1024, event_bytes);
+
+    que.put(event{make_message("abc", "12345")});
+    que.put_priority(event{connected_event{}});
+    REQUIRE(que.size_bytes() == 8);
+
+    auto cque = consumer_queue<>::create();
+    cque->put(event{make_message("a/b", "xyz")});
+    REQUIRE(cque->size_bytes() == 0);
+}
+
+TEST_CASE("thread_queue stats", "[thread_queue]")
+{
+    thread_queue<int> que{2};
+
+    // Depth is always tracked
+    que.put(1);
+    auto st = que.stats();
+    REQUIRE(st.depth == 1);
+    REQUIRE(st.enqueued == 0);
+
+    que.enable_stats();
+    REQUIRE(que.stats_enabled());
+
+    que.put(2);
+    std::this_thread::sleep_for(5ms);
+
+    st = que.stats();
+    REQUIRE(st.enqueued == 1);
+    REQUIRE(st.depth == 2);
+    REQUIRE(st.maxDepth == 2);
+    REQUIRE(st.headAge >= 5ms);
+
+    // Producer blocks on the full queue
+    auto thr = std::thread([&que] {
+        std::this_thread::sleep_for(10ms);
+        que.get();
+    });
+    que.put(3);
+    thr.join();
+
+    st = que.stats();
+    REQUIRE(st.enqueued == 2);
+    REQUIRE(st.dequeued == 1);
+    REQUIRE(st.putBlockedTime >= 5ms);
+
+    std::vector<int> vec;
+    REQUIRE(que.try_get_n(vec, 4) == 2);
+
+    // Consumer waits on the empty queue
+    thr = std::thread([&que] {
+        std::this_thread::sleep_for(10ms);
+        que.put(4);
+    });
+    REQUIRE(que.get() == 4);
+    thr.join();
+
+    st = que.stats();
+    REQUIRE(st.dequeued == 4);
+    REQUIRE(st.depth == 0);
+    REQUIRE(st.headAge == 0ns);
+    REQUIRE(st.getWaitTime >= 5ms);
+
+    que.reset_stats();
+    st = que.stats();
+    REQUIRE(st.enqueued == 0);
+    REQUIRE(st.maxDepth == 0);
+    REQUIRE(st.getWaitTime == 0ns);
+}
+
+TEST_CASE("thread_queue consumer stats", "[thread_queue]")
+{
+    auto que = consumer_queue<>::create();
+    que->enable_stats();
+    que->put(event{connected_event{}});
+
+    auto st = que->stats();
+    REQUIRE(st.enqueued == 1);
+    REQUIRE(st.depth == 1);
+}
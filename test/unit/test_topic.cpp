@@ -22,6 +22,8 @@
 #include <algorithm>
 #include <memory>
 #include <stdexcept>
+#include <string_view>
+#include <vector>
 
 #include "catch2_version.h"
 #include "mock_async_client.h"
@@ -64,6 +66,26 @@ TEST_CASE("basic ctor", "[topic]")
 
 // ----------------------------------------------------------------------
 
+TEST_CASE("template ctor", "[topic]")
+{
+    mqtt::topic topic{cli, topic_template{"site/{}/sensor/{}"}, QOS, RETAINED};
+
+    REQUIRE(topic.has_template());
+    REQUIRE("site/{}/sensor/{}" == topic.get_name());
+    REQUIRE(2 == topic.get_template().size());
+    REQUIRE(QOS == topic.get_qos());
+
+    // A copy has its own pattern
+    mqtt::topic copy{topic};
+    REQUIRE(copy.has_template());
+    REQUIRE(copy.get_template().pattern().data() != topic.get_template().pattern().data());
+    REQUIRE("site/{}/sensor/{}" == copy.get_template().pattern());
+
+    REQUIRE(!mqtt::topic{cli, TOPIC}.has_template());
+}
+
+// ----------------------------------------------------------------------
+
 TEST_CASE("full ctor", "[topic]")
 {
     mqtt::topic topic{cli, TOPIC, QOS, RETAINED};
@@ -115,6 +137,67 @@ TEST_CASE("split", "[topic]")
     REQUIRE("name" == v[2]);
 }
 
+TEST_CASE("split_view", "[topic]")
+{
+    std::vector<std::string_view> v;
+    for (auto field : topic::split_view(TOPIC)) v.push_back(field);
+
+    REQUIRE(3 == v.size());
+    REQUIRE("my" == v[0]);
+    REQUIRE("topic" == v[1]);
+    REQUIRE("name" == v[2]);
+
+    // The same fields as split(), including empty ones
+    for (string top : {"", "a", "/", "a/", "/a", "a//b", "//", "$SYS/x/y"}) {
+        auto want = topic::split(top);
+        topic_fields fields{top};
+        std::vector<string> got(fields.begin(), fields.end());
+        REQUIRE(want == got);
+        REQUIRE(fields.empty() == top.empty());
+    }
+}
+
+TEST_CASE("valid name", "[topic]")
+{
+    REQUIRE(topic::is_valid_name(TOPIC));
+    REQUIRE(topic::is_valid_name("/"));
+    REQUIRE(topic::is_valid_name("$SYS/broker"));
+    REQUIRE(topic::is_valid_name("caf\xC3\xA9/\xE2\x82\xAC/\xF0\x9F\x98\x80"));
+
+    REQUIRE(!topic::is_valid_name(""));
+    REQUIRE(!topic::is_valid_name("a/+/b"));
+    REQUIRE(!topic::is_valid_name("a/#"));
+    REQUIRE(!topic::is_valid_name(std::string_view{"a\0b", 3}));
+    REQUIRE(!topic::is_valid_name(string(65536, 'a')));
+
+    // Bad UTF-8: stray continuation, overlong, surrogate, past U+10FFFF,
+    // and truncated sequences.
+    for (auto bad : {"\x80", "\xC0\xAF", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xE2\x82"})
+        REQUIRE(!topic::is_valid_name(string{"a/"} + bad));
+
+    // Check each position in long topics, which are scanned in vectors
+    const string base(100, 'x');
+    for (size_t i = 0; i < base.size(); ++i) {
+        for (char c : {'+', '#', '\0', '\xFF'}) {
+            auto name = base;
+            name[i] = c;
+            REQUIRE(!topic::is_valid_name(name));
+        }
+        auto name = base;
+        name.replace(i, 1, "\xC3\xA9");
+        REQUIRE(topic::is_valid_name(name));
+    }
+
+    try {
+        topic::validate_name("a/+");
+        FAIL("A wildcard should fail");
+    }
+    catch (const exception& exc) {
+        REQUIRE(exc.get_reason_code() == ReasonCode::TOPIC_NAME_INVALID);
+    }
+    REQUIRE_NOTHROW(topic::validate_name(TOPIC));
+}
+
 // ----------------------------------------------------------------------
 // Publish
 // ----------------------------------------------------------------------
@@ -191,6 +274,38 @@ TEST_CASE("publish full binary", "[topic]")
     REQUIRE(RETAINED == msg->is_retained());
 }
 
+// ----------------------------------------------------------------------
+
+TEST_CASE("publish fields", "[topic]")
+{
+    mqtt::topic topic{cli, topic_template{"site/{}/sensor/{}"}, QOS, RETAINED};
+
+    auto tok = topic.publish_fields(PAYLOAD, 42, "temp");
+    REQUIRE(tok);
+
+    auto msg = tok->get_message();
+    REQUIRE(msg);
+
+    REQUIRE("site/42/sensor/temp" == msg->get_topic());
+    REQUIRE(PAYLOAD == msg->get_payload());
+    REQUIRE(QOS == msg->get_qos());
+    REQUIRE(RETAINED == msg->is_retained());
+
+    // Messages on the same topic share its name
+    auto msg2 = topic.publish_fields(PAYLOAD, 42, std::string{"temp"})->get_message();
+    REQUIRE(msg2->get_topic_ref().ptr() == msg->get_topic_ref().ptr());
+
+    auto msg3 = topic.publish_fields(PAYLOAD, 7, "temp")->get_message();
+    REQUIRE("site/7/sensor/temp" == msg3->get_topic());
+
+    REQUIRE_THROWS_AS(topic.publish_fields(PAYLOAD, 42), std::invalid_argument);
+
+    // A topic without a template has no fields
+    mqtt::topic plain{cli, TOPIC};
+    REQUIRE(TOPIC == plain.publish_fields(PAYLOAD)->get_message()->get_topic());
+    REQUIRE_THROWS_AS(plain.publish_fields(PAYLOAD, 42), std::invalid_argument);
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //						topic_filter
 /////////////////////////////////////////////////////////////////////////////
@@ -203,6 +318,85 @@ TEST_CASE("topic has_wildcards", "[topic_filter]")
     REQUIRE(topic_filter::has_wildcards("some/multi/wild/#"));
 }
 
+TEST_CASE("topic shared", "[topic_filter]")
+{
+    REQUIRE(topic_filter::is_shared("$share/group/some/+/topic"));
+    REQUIRE(topic_filter::share_group("$share/group/some/+/topic") == "group");
+    REQUIRE(topic_filter::strip_share("$share/group/some/+/topic") == "some/+/topic");
+    REQUIRE(topic_filter::strip_share("$share/group/#") == "#");
+
+    // Not shared subscriptions
+    for (auto filt : {"some/+/topic", "$share", "$share/group", "$share/group/", "$share//a",
+                      "$share/gr+up/a", "$share/#", "$SHARE/group/a", "x/$share/group/a"}) {
+        REQUIRE(!topic_filter::is_shared(filt));
+        REQUIRE(topic_filter::share_group(filt).empty());
+        REQUIRE(topic_filter::strip_share(filt) == filt);
+    }
+
+    topic_filter filt{"$share/group/my/+/name"};
+    REQUIRE(filt.is_shared());
+    REQUIRE(filt.share_group() == "group");
+    REQUIRE(filt.has_wildcards());
+    REQUIRE(filt.matches("my/topic/name"));
+    REQUIRE(!filt.matches("my/other/id"));
+    REQUIRE(!filt.matches("$share/group/my/topic/name"));
+
+    REQUIRE(!topic_filter{"my/+/name"}.is_shared());
+}
+
+TEST_CASE("topic captures", "[topic_filter]")
+{
+    topic_captures caps;
+
+    topic_filter filt{"site/+/line/+/temp"};
+    REQUIRE(filt.matches("site/42/line/7/temp", caps));
+    REQUIRE(caps.size() == 2);
+    REQUIRE(caps[0] == "42");
+    REQUIRE(caps[1] == "7");
+    REQUIRE(!caps.has_tail());
+
+    REQUIRE(!filt.matches("site/42/line/7/pressure", caps));
+    REQUIRE(!filt.matches("site/42/line/7/temp/max", caps));
+    REQUIRE(!filt.matches("site/42/line", caps));
+
+    topic_filter hfilt{"site/+/#"};
+    string topic{"site/42/line/7/temp"};
+    REQUIRE(hfilt.matches(topic, caps));
+    REQUIRE(caps.size() == 1);
+    REQUIRE(caps[0] == "42");
+    REQUIRE(caps.has_tail());
+    REQUIRE(caps.tail() == "line/7/temp");
+
+    // The captures are views into the topic
+    REQUIRE(caps[0].data() == topic.data() + 5);
+
+    REQUIRE(topic_filter{"#"}.matches("a/b", caps));
+    REQUIRE(caps.tail() == "a/b");
+    REQUIRE(!topic_filter{"#"}.matches("$SYS/b", caps));
+    REQUIRE(!topic_filter{"+/b"}.matches("$SYS/b", caps));
+
+    REQUIRE(topic_filter{"a/+/c"}.matches("a//c", caps));
+    REQUIRE(caps.size() == 1);
+    REQUIRE(caps[0].empty());
+
+    REQUIRE(topic_filter{"a/b"}.matches("a/b", caps));
+    REQUIRE(caps.empty());
+
+    // From a filter string, including a shared subscription
+    topic_captures scaps{"$share/grp/site/+/line/+/#", "site/42/line/7/temp"};
+    REQUIRE(std::vector<std::string_view>(scaps.begin(), scaps.end()) ==
+            std::vector<std::string_view>{"42", "7"});
+    REQUIRE(scaps.tail() == "temp");
+
+    // Too many wildcards
+    string many{"+"}, mtopic{"x"};
+    for (size_t i = 0; i < topic_captures::MAX_CAPTURES; ++i) {
+        many += "/+";
+        mtopic += "/x";
+    }
+    REQUIRE_THROWS_AS(topic_filter{many}.matches(mtopic, caps), std::length_error);
+}
+
 TEST_CASE("topic matches", "[topic_filter]")
 {
     SECTION("no_wildcards")
@@ -274,4 +468,14 @@ TEST_CASE("topic matches", "[topic_filter]")
         REQUIRE(!topic_filter{"$BOB/bar"}.matches("$SYS/bar"));
         REQUIRE(!topic_filter{"+/bar"}.matches("$SYS/bar"));
     }
+
+    SECTION("topic_types")
+    {
+        topic_filter filt{"foo/+/baz"};
+        string topic{"foo/bar/baz/qux"};
+
+        REQUIRE(!filt.matches(topic));
+        REQUIRE(filt.matches(std::string_view{topic}.substr(0, 11)));
+        REQUIRE(!filt.matches(std::string_view{topic}.substr(0, 7)));
+    }
 }
@@ -0,0 +1,116 @@
+// test_topic_alias_table.cpp
+//
+// Unit tests for the topic_alias_table class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ *******************************************************************************/
+
+
+#define UNIT_TESTS
+
+#include "catch2_version.h"
+#include "mqtt/topic_alias_table.h"
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("alias table assign", "[topic_alias_table]")
+{
+    topic_alias_table tbl{4};
+
+    REQUIRE(tbl.enabled());
+    REQUIRE(tbl.capacity() == 4);
+    REQUIRE(tbl.size() == 0);
+
+    auto [a1, new1] = tbl.assign("some/long/topic");
+    REQUIRE(a1 == 1);
+    REQUIRE(new1);
+
+    auto [a2, new2] = tbl.assign("other/topic");
+    REQUIRE(a2 == 2);
+    REQUIRE(new2);
+
+    // Reusing a topic gets the same alias, which is no longer new
+    auto [a3, new3] = tbl.assign("some/long/topic");
+    REQUIRE(a3 == 1);
+    REQUIRE(!new3);
+
+    REQUIRE(tbl.size() == 2);
+    REQUIRE(tbl.find("other/topic") == 2);
+    REQUIRE(tbl.find("no/topic") == 0);
+
+    REQUIRE(tbl.remove("other/topic"));
+    REQUIRE(!tbl.remove("other/topic"));
+    REQUIRE(tbl.find("other/topic") == 0);
+    REQUIRE(tbl.size() == 1);
+}
+
+TEST_CASE("alias table evict", "[topic_alias_table]")
+{
+    topic_alias_table tbl{3};
+
+    REQUIRE(tbl.assign("a").first == 1);
+    REQUIRE(tbl.assign("b").first == 2);
+    REQUIRE(tbl.assign("c").first == 3);
+
+    // All were used since the hand passed, so it sweeps around once,
+    // clearing them, and takes the first one.
+    auto [ad, newd] = tbl.assign("d");
+    REQUIRE(ad == 1);
+    REQUIRE(newd);
+    REQUIRE(tbl.find("a") == 0);
+    REQUIRE(tbl.size() == 3);
+
+    // Using 'b' again protects it, so 'c' is the next to go.
+    REQUIRE(!tbl.assign("b").second);
+    auto [ae, newe] = tbl.assign("e");
+    REQUIRE(ae == 3);
+    REQUIRE(newe);
+    REQUIRE(tbl.find("c") == 0);
+    REQUIRE(tbl.find("b") == 2);
+
+    // A removed alias is reused ahead of any in use
+    tbl.remove("d");
+    REQUIRE(tbl.assign("f").first == 1);
+    REQUIRE(tbl.find("b") == 2);
+    REQUIRE(tbl.find("e") == 3);
+}
+
+TEST_CASE("alias table reset", "[topic_alias_table]")
+{
+    topic_alias_table tbl;
+
+    // Disabled by default
+    REQUIRE(!tbl.enabled());
+    auto [a, isNew] = tbl.assign("some/topic");
+    REQUIRE(a == 0);
+    REQUIRE(!isNew);
+    REQUIRE(tbl.size() == 0);
+
+    tbl.reset(8);
+    REQUIRE(tbl.enabled());
+    REQUIRE(tbl.assign("some/topic").first == 1);
+
+    // A new connection starts over
+    tbl.reset(8);
+    REQUIRE(tbl.size() == 0);
+    REQUIRE(tbl.find("some/topic") == 0);
+    REQUIRE(tbl.assign("some/topic").second);
+
+    tbl.reset(0);
+    REQUIRE(!tbl.enabled());
+    REQUIRE(tbl.size() == 0);
+}
@@ -0,0 +1,104 @@
+// test_topic_intern_table.cpp
+//
+// Unit tests for the topic_intern_table class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ *******************************************************************************/
+
+
+#define UNIT_TESTS
+
+#include "catch2_version.h"
+#include "mqtt/topic_intern_table.h"
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("intern table shares topics", "[topic_intern_table]")
+{
+    topic_intern_table tbl{16};
+
+    REQUIRE(tbl.capacity() == 16);
+    REQUIRE(tbl.size() == 0);
+
+    auto t1 = tbl.intern("some/random/topic");
+    REQUIRE(t1.str() == "some/random/topic");
+    REQUIRE(tbl.misses() == 1);
+
+    // The same topic gets the same buffer
+    auto t2 = tbl.intern("some/random/topic");
+    REQUIRE(t2.ptr() == t1.ptr());
+    REQUIRE(tbl.hits() == 1);
+
+    auto t3 = tbl.intern("other/topic");
+    REQUIRE(t3.ptr() != t1.ptr());
+    REQUIRE(tbl.size() == 2);
+
+    tbl.clear();
+    REQUIRE(tbl.size() == 0);
+
+    // Still valid after it's gone from the table
+    REQUIRE(t1.str() == "some/random/topic");
+    REQUIRE(tbl.intern("some/random/topic").ptr() != t1.ptr());
+}
+
+TEST_CASE("intern table evict", "[topic_intern_table]")
+{
+    topic_intern_table tbl{2};
+
+    auto a = tbl.intern("a");
+    tbl.intern("b");
+    tbl.intern("c");
+
+    REQUIRE(tbl.size() == 2);
+    REQUIRE(a.str() == "a");
+
+    // 'a' was evicted, so it gets a new buffer
+    REQUIRE(tbl.intern("a").ptr() != a.ptr());
+    REQUIRE(tbl.size() == 2);
+
+    REQUIRE_THROWS_AS(topic_intern_table{0}, std::invalid_argument);
+}
+
+TEST_CASE("intern table aliases", "[topic_intern_table]")
+{
+    topic_intern_table tbl;
+
+    REQUIRE(tbl.capacity() == topic_intern_table::DFLT_CAPACITY);
+
+    // An unknown alias has no topic
+    REQUIRE(tbl.resolve("", 3).is_null());
+
+    // A topic with an alias maps the alias
+    auto t1 = tbl.resolve("some/long/topic", 3);
+    REQUIRE(t1.str() == "some/long/topic");
+    REQUIRE(tbl.alias_topic(3).ptr() == t1.ptr());
+
+    // Then the alias alone gets the topic
+    auto t2 = tbl.resolve("", 3);
+    REQUIRE(t2.ptr() == t1.ptr());
+
+    // The server can remap an alias
+    auto t3 = tbl.resolve("other/topic", 3);
+    REQUIRE(tbl.resolve("", 3).ptr() == t3.ptr());
+
+    // Topics without aliases are just interned
+    REQUIRE(tbl.resolve("other/topic", 0).ptr() == t3.ptr());
+
+    tbl.clear_aliases();
+    REQUIRE(tbl.resolve("", 3).is_null());
+    REQUIRE(tbl.size() == 2);
+}
@@ -0,0 +1,110 @@
+// test_topic_match_cache.cpp
+//
+// Unit tests for the topic_match_cache class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ *******************************************************************************/
+
+#define UNIT_TESTS
+
+#include "catch2_version.h"
+#include "mqtt/topic_match_cache.h"
+
+using namespace mqtt;
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("match cache hits", "[topic_match_cache]")
+{
+    topic_matcher<int> tm{{"some/+/topic", 33}, {"some/#", 99}};
+    topic_match_cache<int> cache{tm, 16};
+
+    REQUIRE(cache.capacity() == 16);
+    REQUIRE(cache.size() == 0);
+
+    REQUIRE(cache.matches("some/random/topic").size() == 2);
+    REQUIRE(cache.misses() == 1);
+    REQUIRE(cache.hits() == 0);
+
+    auto& res = cache.matches("some/random/topic");
+    REQUIRE(res.size() == 2);
+    REQUIRE(cache.hits() == 1);
+    REQUIRE(cache.size() == 1);
+
+    int sum = 0;
+    for (const auto* val : res) sum += val->second;
+    REQUIRE(sum == 132);
+
+    REQUIRE(cache.matches("other/topic").empty());
+    REQUIRE(cache.matches("other/topic").empty());
+    REQUIRE(cache.hits() == 2);
+    REQUIRE(cache.size() == 2);
+
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+    REQUIRE(cache.matches("other/topic").empty());
+    REQUIRE(cache.misses() == 3);
+}
+
+TEST_CASE("match cache invalidate", "[topic_match_cache]")
+{
+    topic_matcher<int> tm{{"some/+/topic", 33}};
+    topic_match_cache<int> cache{tm, 16};
+
+    REQUIRE(cache.matches("some/random/topic").size() == 1);
+
+    auto gen = tm.generation();
+    tm.insert({"some/#", 99});
+    REQUIRE(tm.generation() != gen);
+
+    REQUIRE(cache.matches("some/random/topic").size() == 2);
+    REQUIRE(cache.misses() == 2);
+
+    tm.remove("some/+/topic");
+    auto& res = cache.matches("some/random/topic");
+    REQUIRE(res.size() == 1);
+    REQUIRE(res[0]->second == 99);
+    REQUIRE(cache.misses() == 3);
+
+    // Removing something that isn't there doesn't change anything
+    gen = tm.generation();
+    tm.remove("not/there");
+    REQUIRE(tm.generation() == gen);
+}
+
+TEST_CASE("match cache evict", "[topic_match_cache]")
+{
+    topic_matcher<int> tm{{"#", 1}};
+    topic_match_cache<int> cache{tm, 2};
+
+    cache.matches("a");
+    cache.matches("b");
+    REQUIRE(cache.size() == 2);
+
+    // Both have been used, so the clock clears them both, and evicts "a"
+    cache.matches("c");
+    REQUIRE(cache.size() == 2);
+
+    // "c" was just added, so "b" goes next, keeping "c"
+    cache.matches("d");
+
+    auto nMiss = cache.misses();
+    cache.matches("c");
+    REQUIRE(cache.misses() == nMiss);
+    cache.matches("b");
+    REQUIRE(cache.misses() == nMiss + 1);
+
+    REQUIRE_THROWS_AS((topic_match_cache<int>{tm, 0}), std::invalid_argument);
+}
@@ -19,6 +19,9 @@
 
 #define UNIT_TESTS
 
+#include <algorithm>
+#include <memory>
+
 #include "catch2_version.h"
 #include "mqtt/topic_matcher.h"
 
@@ -89,3 +92,183 @@ TEST_CASE("matcher matches", "[topic_matcher]")
     REQUIRE(!(topic_matcher<int>{{"$BOB/bar", 42}}.has_match("$SYS/bar")));
     REQUIRE(!(topic_matcher<int>{{"+/bar", 42}}.has_match("$SYS/bar")));
 }
+
+TEST_CASE("matcher topic lifetime", "[topic_matcher]")
+{
+    topic_matcher<int> tm{{"some/+/topic", 33}, {"some/#", 99}};
+
+    // The iterator owns a temporary topic
+    int n = 0;
+    for (auto it = tm.matches(string{"some/random/topic"}); it != tm.matches_end(); ++it) ++n;
+    REQUIRE(n == 2);
+
+    // The iterator keeps a copy of a caller's string
+    auto ptopic = std::make_unique<string>("some/random/topic");
+    auto sit = tm.matches(*ptopic);
+    ptopic.reset();
+
+    n = 0;
+    for (; sit != tm.matches_end(); ++sit) ++n;
+    REQUIRE(n == 2);
+
+    // The iterator refers to the caller's topic view
+    const string topic{"some/other/topic"};
+    auto it = tm.matches(std::string_view{topic});
+    auto cpy = it;
+
+    n = 0;
+    for (; it != tm.matches_end(); ++it) ++n;
+    REQUIRE(n == 2);
+
+    // A copy carries on from the same place
+    n = 0;
+    for (; cpy != tm.matches_end(); cpy++) ++n;
+    REQUIRE(n == 2);
+}
+
+TEST_CASE("matcher deep topic", "[topic_matcher]")
+{
+    // Enough levels of '+' branches to spill the search stack
+    const int N = 40;
+
+    string filter, wild, topic;
+    for (int i = 0; i < N; ++i) {
+        auto sep = (i == 0) ? "" : "/";
+        auto field = std::to_string(i);
+        filter += sep + field;
+        wild += sep + string{(i % 2) ? "+" : field.c_str()};
+        topic += sep + field;
+    }
+
+    topic_matcher<int> tm{{filter, 1}, {wild, 2}, {"#", 3}};
+
+    int sum = 0;
+    for (auto it = tm.matches(topic); it != tm.matches_end(); ++it) sum += it->second;
+    REQUIRE(sum == 6);
+
+    REQUIRE(!tm.has_match("$SYS/" + topic));
+    REQUIRE(!topic_matcher<int>{{filter, 1}}.has_match(topic + "/more"));
+}
+
+TEST_CASE("matcher shared", "[topic_matcher]")
+{
+    topic_matcher<int> tm{
+        {"$share/g1/some/+/topic", 1},
+        {"$share/g2/some/+/topic", 2},
+        {"some/+/topic", 3},
+        {"$share/g1/some/#", 4},
+        {"some/#", 5},
+        {"$share/g1/#", 6}
+    };
+
+    auto find_all = [&](const string& topic) {
+        std::vector<int> v;
+        for (auto it = tm.matches(topic); it != tm.matches_end(); ++it)
+            v.push_back(it->second);
+        std::sort(v.begin(), v.end());
+        return v;
+    };
+
+    REQUIRE(find_all("some/random/topic") == std::vector<int>{1, 2, 3, 4, 5, 6});
+    REQUIRE(find_all("some/random") == std::vector<int>{4, 5, 6});
+    REQUIRE(find_all("other") == std::vector<int>{6});
+    REQUIRE(find_all("$SYS/x").empty());
+    REQUIRE(!tm.has_match("$share/g1/some/random/topic"));
+
+    // Each group is a separate entry, kept with its full filter
+    auto it = tm.find("$share/g2/some/+/topic");
+    REQUIRE(it != tm.end());
+    REQUIRE(it->first == "$share/g2/some/+/topic");
+    REQUIRE(it->second == 2);
+    REQUIRE(!(tm.find("$share/g3/some/+/topic") != tm.end()));
+
+    size_t n = 0;
+    for (auto it = tm.cbegin(); it != tm.cend(); ++it) ++n;
+    REQUIRE(n == 6);
+
+    REQUIRE(tm.remove("$share/g1/some/+/topic"));
+    REQUIRE(find_all("some/random/topic") == std::vector<int>{2, 3, 4, 5, 6});
+
+    std::vector<string> topics{"some/random/topic", "some/random", "other"};
+    std::vector<topic_matcher<int>::batch_result> out;
+    REQUIRE(tm.match_batch(topics, out) == 5 + 3 + 1);
+}
+
+TEST_CASE("matcher captures", "[topic_matcher]")
+{
+    topic_matcher<int> tm{
+        {"site/+/line/+/temp", 1}, {"site/+/#", 2}, {"$share/g/site/42/+/+/temp", 3}
+    };
+
+    string topic{"site/42/line/7/temp"};
+    int n = 0;
+
+    for (auto it = tm.matches(topic); it != tm.matches_end(); ++it, ++n) {
+        auto caps = it.captures();
+        switch (it->second) {
+            case 1:
+                REQUIRE(caps.size() == 2);
+                REQUIRE(caps[0] == "42");
+                REQUIRE(caps[1] == "7");
+                REQUIRE(!caps.has_tail());
+                break;
+            case 2:
+                REQUIRE(caps.size() == 1);
+                REQUIRE(caps[0] == "42");
+                REQUIRE(caps.tail() == "line/7/temp");
+                break;
+            case 3:
+                REQUIRE(caps.size() == 2);
+                REQUIRE(caps[0] == "line");
+                REQUIRE(caps[1] == "7");
+                break;
+        }
+    }
+    REQUIRE(n == 3);
+}
+
+TEST_CASE("matcher batch", "[topic_matcher]")
+{
+    topic_matcher<int> tm{
+        {"a/b/c", 1}, {"a/+/c", 2}, {"a/#", 3},     {"#", 4},       {"+/b", 5},
+        {"a/b", 6},   {"$SYS/x", 7}, {"$SYS/#", 8}, {"a/b/c/d", 9}, {"x//y", 10}
+    };
+
+    std::vector<string> topics;
+    for (auto f1 : {"a", "b", "$SYS", "x", ""}) {
+        for (auto f2 : {"b", "x", ""}) {
+            topics.push_back(string{f1} + "/" + f2);
+            for (auto f3 : {"c", "y"}) {
+                topics.push_back(string{f1} + "/" + f2 + "/" + f3);
+                topics.push_back(string{f1} + "/" + f2 + "/" + f3 + "/d");
+            }
+        }
+        topics.push_back(f1);
+    }
+
+    // Large enough to split across threads
+    const size_t N = 4096 / topics.size() + 1;
+    std::vector<string> batch;
+    for (size_t i = 0; i < N; ++i) batch.insert(batch.end(), topics.begin(), topics.end());
+
+    for (size_t nThreads : {1, 4}) {
+        std::vector<topic_matcher<int>::batch_result> out{{999, nullptr}};
+        auto n = tm.match_batch(batch, out, nThreads);
+        REQUIRE(n == out.size() - 1);
+
+        // Split the results back out by topic, and compare to matches()
+        auto res = out.begin() + 1;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            std::vector<int> want, got;
+            for (auto it = tm.matches(batch[i]); it != tm.matches_end(); ++it)
+                want.push_back(it->second);
+            for (; res != out.end() && res->first == i; ++res)
+                got.push_back(res->second->second);
+
+            std::sort(want.begin(), want.end());
+            std::sort(got.begin(), got.end());
+            REQUIRE(want == got);
+        }
+        REQUIRE(res == out.end());
+    }
+}
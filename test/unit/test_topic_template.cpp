@@ -0,0 +1,90 @@
+// test_topic_template.cpp
+//
+// Unit tests for the topic_template class in the Paho MQTT C++ library.
+//
+
+/*******************************************************************************
+ * Copyright (c) 2026 Frank Pagliughi <fpagliughi@mindspring.com>
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v2.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v20.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ *******************************************************************************/
+
+
+#define UNIT_TESTS
+
+#include <cstdint>
+#include <string>
+
+#include "catch2_version.h"
+#include "mqtt/topic_template.h"
+
+using namespace mqtt;
+
+// Checked when compiled
+static constexpr topic_template SENSOR{"site/{}/sensor/{}"};
+static_assert(SENSOR.size() == 2, "wrong number of fields");
+
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("template parse", "[topic_template]")
+{
+    REQUIRE(SENSOR.pattern() == "site/{}/sensor/{}");
+    REQUIRE(!SENSOR.empty());
+
+    topic_template plain{"some/topic"};
+    REQUIRE(plain.empty());
+    REQUIRE(plain.format() == "some/topic");
+
+    REQUIRE(topic_template{"{}"}.size() == 1);
+    REQUIRE(topic_template{"a/{}{}/b"}.size() == 2);
+
+    REQUIRE_THROWS_AS(topic_template{""}, std::invalid_argument);
+    REQUIRE_THROWS_AS(topic_template{"site/{/x"}, std::invalid_argument);
+    REQUIRE_THROWS_AS(topic_template{"site/{"}, std::invalid_argument);
+    REQUIRE_THROWS_AS(topic_template{"site/}/x"}, std::invalid_argument);
+    REQUIRE_THROWS_AS(topic_template{"site/+/{}"}, std::invalid_argument);
+    REQUIRE_THROWS_AS(topic_template{"site/{}/#"}, std::invalid_argument);
+    std::string_view nul{"a\0b", 3};
+    REQUIRE_THROWS_AS(topic_template{nul}, std::invalid_argument);
+
+    std::string many;
+    for (size_t i = 0; i <= topic_template::MAX_FIELDS; ++i) many += "{}/";
+    REQUIRE_THROWS_AS(topic_template{many}, std::length_error);
+}
+
+TEST_CASE("template format", "[topic_template]")
+{
+    REQUIRE(SENSOR.format(42, "temp") == "site/42/sensor/temp");
+    REQUIRE(SENSOR.format(-1, std::string{"x"}) == "site/-1/sensor/x");
+    REQUIRE(SENSOR.format(uint64_t(18446744073709551615u), std::string_view{"y"}) ==
+            "site/18446744073709551615/sensor/y");
+
+    REQUIRE(topic_template{"{}/a/{}"}.format("x", 1) == "x/a/1");
+    REQUIRE(topic_template{"a/{}{}"}.format("x", 1) == "a/x1");
+
+    REQUIRE_THROWS_AS(SENSOR.format(42), std::invalid_argument);
+    REQUIRE_THROWS_AS(SENSOR.format(42, "temp", 3), std::invalid_argument);
+}
+
+TEST_CASE("template format_to", "[topic_template]")
+{
+    std::string buf;
+
+    const auto& name = SENSOR.format_to(buf, 1, "humidity");
+    REQUIRE(&name == &buf);
+    REQUIRE(buf == "site/1/sensor/humidity");
+
+    // The buffer is reused, without growing for a shorter name
+    auto cap = buf.capacity();
+    SENSOR.format_to(buf, 2, "temp");
+    REQUIRE(buf == "site/2/sensor/temp");
+    REQUIRE(buf.capacity() == cap);
+}